@@ -5,64 +5,98 @@
  *  Detailed documentation may be found in the header file DFA.h
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <set>
+#include <unordered_map>
 #include "inc/DFA.h"
+#include "inc/pattern_match.h"
+#include "inc/symbol_table.h"
 
-/** @brief Sets the current_permutation array to the next permutation
- *
- * Finds the lexicographically next permutation from the inputted current permutation,
- * where no value will exceed max_value.  Behaviour is undefined if the input
- * is invalid.
+static void vec_2d_print(const std::vector<int>& v, int cols, FILE *f);
+
+/** @brief Adds a value to both lanes of a digest
  *
- * @param current_permutation Current permutation
- * @param length Length of the array
- * @param max_value Maximum value an entry in the permutation can take
- * @return 0 on success, negative error code on failure
+ * @param digest Digest to update
+ * @param value Value to add
  */
-static int get_next_permutation(std::vector<int>& current_permutation, int max_value);
-
-static bool vec_contains_duplicates(std::vector<int>& v);
-
-static int vec_index_of(std::vector<int>& v, int val);
+static inline void digest_mix(dfa_digest_t& digest, uint32_t value);
 
-static void vec_2d_print(const std::vector<std::vector<int>>& v, FILE *f);
+/** @brief Finalizes a digest once all values are added
+ *
+ * @param digest Digest to finalize
+ */
+static inline void digest_finish(dfa_digest_t& digest);
 
 /* *****     IMPLEMENTATION     ***** */
+dfa_alphabet::dfa_alphabet(const std::vector<int>& symbols) {
+    this->symbols = symbols;
+    int max_id = -1;
+    for(int id : symbols) max_id = std::max(max_id, id);
+    this->lookup.assign(max_id + 1, DFA_INVALID_SYMBOL);
+    for(int i = 0; i < symbols.size(); i++) {
+        assert(this->lookup[symbols[i]] == DFA_INVALID_SYMBOL);
+        this->lookup[symbols[i]] = i;
+    }
+}
+
 dfa::dfa(int num_states, int alphabet_size, int initial_state,
          std::vector<bool>& finals, const std::vector<std::string>& symbols,
          const int *transition_matrix) {
-    DFA_constructor_helper(num_states, alphabet_size, initial_state,
-            finals, symbols, transition_matrix);
+    assert(symbols.size() == alphabet_size);
+    auto ids = std::vector<int>(alphabet_size);
+    for(int i = 0; i < alphabet_size; i++) {
+        ids[i] = symbol_intern(symbols[i]);
+    }
+    DFA_constructor_helper(num_states, initial_state, finals,
+            std::make_shared<const dfa_alphabet>(ids), transition_matrix);
 }
-void dfa::DFA_constructor_helper(int num_states, int alphabet_size, int initial_state,
-        std::vector<bool>& finals, const std::vector<std::string>& symbols,
+
+dfa::dfa(int num_states, int initial_state, std::vector<bool>& finals,
+         std::shared_ptr<const dfa_alphabet> alphabet, const int *transition_matrix) {
+    DFA_constructor_helper(num_states, initial_state, finals,
+            std::move(alphabet), transition_matrix);
+}
+
+void dfa::DFA_constructor_helper(int num_states, int initial_state,
+        std::vector<bool>& finals, std::shared_ptr<const dfa_alphabet> alphabet,
         const int *transition_matrix) {
     assert(initial_state < num_states && initial_state >= 0);
+    int alphabet_size = alphabet->symbols.size();
 
     this->num_states = num_states;
     this->initial_state = initial_state;
+    this->alphabet_size = alphabet_size;
     for(int i = 0; i < num_states; i++) {
         if (finals[i]) this->final_states.insert(i);
     }
 
-    this->alphabet_symbols = std::vector<std::string>(symbols);
-    this->transition_matrix.resize(num_states);
-    for(int state = 0; state < num_states; state++) {
-        this->transition_matrix[state].resize(alphabet_size);
-        for(int letter = 0; letter < alphabet_size; letter++) {
-            int target_state = transition_matrix[state * alphabet_size + letter];
-            assert(target_state < num_states && target_state >= -1);
-            this->transition_matrix[state][letter] = target_state;
-        }
+    this->alphabet = std::move(alphabet);
+    this->transition_matrix.assign(transition_matrix,
+            transition_matrix + (size_t) num_states * alphabet_size);
+    for(int target_state : this->transition_matrix) {
+        assert(target_state < num_states && target_state >= -1);
+        (void) target_state;
     }
 }
 
 int dfa::get_symbol_index(const std::string& symbol) {
-    auto it = std::find(this->alphabet_symbols.begin(), this->alphabet_symbols.end(), symbol);
-    int result = it - this->alphabet_symbols.begin();
-    return result >= this->alphabet_symbols.size() ? DFA_INVALID_SYMBOL : result;
+    int symbol_id = symbol_find(symbol);
+    return symbol_id == SYMBOL_NOT_FOUND ? DFA_INVALID_SYMBOL : this->get_symbol_index(symbol_id);
+}
+
+const std::string& dfa::get_symbol_name(int symbol_index) const {
+    assert(symbol_index >= 0 && symbol_index < this->alphabet_size);
+    return symbol_name(this->alphabet->symbols[symbol_index]);
+}
+
+std::vector<int> dfa::DFA_align_alphabet(const dfa& other) const {
+    auto alignment = std::vector<int>(this->alphabet_size);
+    for(int i = 0; i < this->alphabet_size; i++) {
+        alignment[i] = other.get_symbol_index(this->alphabet->symbols[i]);
+    }
+    return alignment;
 }
 
 int dfa::DFA_run_trace(const std::vector<std::string>& trace) {
@@ -76,145 +110,409 @@ int dfa::DFA_run_trace(const std::vector<std::string>& trace) {
         if (symbol_index < 0) {
             return DFA_INVALID_ARG;
         }
-        if (this->transition_matrix[current_state][symbol_index] < 0) {
+        if ((current_state = this->apply(current_state, symbol_index)) < 0) {
             return 0;
         }
     }
-    return this->final_states.find(current_state) == this->final_states.end();
+    return this->final_states.find(current_state) != this->final_states.end();
 }
 
 pattern_output *dfa::DFA_find_pattern(dfa& pattern, int skip_counter) {
-    int pattern_states, main_states, main_alphabet_size, pattern_alphabet_size;
-    int find_count = 0;
-    pattern_output *output;
-    pattern_states = pattern.num_states;
-    main_states = this->num_states;
-    main_alphabet_size = this->alphabet_symbols.size();
-    pattern_alphabet_size = pattern.alphabet_symbols.size();
-
-    assert(pattern_states <= main_states);
-
-    auto symbol_permutation = std::vector<int>(pattern_alphabet_size, 0);
-    auto matching = std::vector<int>(pattern_states, 0);
-
-    std::vector<std::string> out_symbols;
-
-    while(get_next_permutation(matching, main_states - 1) == 0) {
-        int reduced_symbol_table[main_alphabet_size][pattern_states];
-
-        for (int i = 0; i < main_alphabet_size; i++) {
-            for(int j = 0; j < pattern_states; j++) {
-                int index, dest = (this->transition_matrix)[matching[j]][i];
-                if ((index = vec_index_of(matching, dest)) >= 0) {
-                    reduced_symbol_table[i][j] = index;
-                } else {
-                    reduced_symbol_table[i][j] = DFA_DUMMY_SYMBOL;
-                }
-            }
+    assert(pattern.num_states <= this->num_states);
+
+    pattern_matcher matcher(*this, pattern);
+    auto *output = new pattern_output;
+    for (int find_count = 0; find_count <= skip_counter; find_count++) {
+        if (!matcher.next(*output)) {
+            delete output;
+            return nullptr;
         }
-        while(get_next_permutation(symbol_permutation, main_alphabet_size - 1) == 0) {
-
-            for (int i = 0; i < pattern_alphabet_size; i++) {
-                for (int j = 0; j < pattern_states; j++) {
-                    int main_dest_val = reduced_symbol_table[symbol_permutation[i]][j];
-                    int pattern_dest_val = pattern.transition_matrix[j][i];
-                    if (pattern_dest_val != DFA_DUMMY_SYMBOL && main_dest_val != pattern_dest_val) {
-                        goto permutation_failed;
-                    }
-                }
-            }
-
-            if (find_count < skip_counter) {
-                find_count++;
-                goto permutation_failed;
-            }
-
-            out_symbols = std::vector<std::string>();
-            for (int i = 0; i < pattern_alphabet_size; i++) {
-                std::string s = this->alphabet_symbols[symbol_permutation[i]];
-                out_symbols.push_back(s);
-            }
-            output = new pattern_output;
-            output->states = std::vector<int>(matching);
-            output->symbols = std::vector<std::string>(out_symbols);
-            return output;
-
-            permutation_failed:
-                continue;
-        }
-
     }
-    return nullptr;
+    return output;
 }
 
 int dfa::DFA_modify(dfa& original_pattern, dfa& target_pattern, int skips) {
-    int original_asize = original_pattern.alphabet_symbols.size();
-    int target_asize = target_pattern.alphabet_symbols.size();
     if (original_pattern.num_states != target_pattern.num_states ||
-            original_asize != target_asize) {
+            original_pattern.alphabet_size != target_pattern.alphabet_size) {
         return DFA_NOT_YET_IMPL;
     }
 
     pattern_output *pattern = DFA_find_pattern(original_pattern, skips);
     if (pattern == nullptr) return DFA_PATTERN_NOT_FOUND;
 
+    int result = DFA_modify(original_pattern, target_pattern, *pattern);
+    delete pattern;
+    return result;
+}
+
+int dfa::DFA_modify(dfa& original_pattern, dfa& target_pattern, const pattern_output& pattern) {
+    int original_asize = original_pattern.alphabet_size;
+    int target_asize = target_pattern.alphabet_size;
+    if (original_pattern.num_states != target_pattern.num_states ||
+            original_asize != target_asize) {
+        return DFA_NOT_YET_IMPL;
+    }
+
     int pattern_states = original_pattern.num_states;
 
     for(int state_no = 0; state_no < pattern_states; state_no++) {
-        int state = pattern->states[state_no];
+        int state = pattern.states[state_no];
         for(int symbol_no = 0; symbol_no < original_asize; symbol_no++) {
-            int symbol_ind = get_symbol_index(pattern->symbols[symbol_no]);
+            int symbol_ind = get_symbol_index(pattern.symbols[symbol_no]);
             if (symbol_ind == DFA_INVALID_SYMBOL) {
                 return DFA_PATTERN_NOT_FOUND;
             }
-            int target = target_pattern.transition_matrix[state_no][symbol_no];
-            this->transition_matrix[state][symbol_ind] =
-                    target == DFA_DUMMY_SYMBOL ? DFA_DUMMY_SYMBOL : pattern->states[target];
+            int target = target_pattern.apply(state_no, symbol_no);
+            this->transition_matrix[(size_t) state * this->alphabet_size + symbol_ind] =
+                    target == DFA_DUMMY_SYMBOL ? DFA_DUMMY_SYMBOL : pattern.states[target];
         }
     }
     return 0;
 }
 
-dfa::dfa(dfa& dfa_1, dfa& dfa_2) {
+dfa::dfa(dfa& dfa_1, dfa& dfa_2) : dfa(dfa_1, dfa_2, false) {}
+
+dfa::dfa(dfa& dfa_1, dfa& dfa_2, bool reachable_only) {
+    if (reachable_only) {
+        DFA_reachable_composition_helper(dfa_1, dfa_2);
+    } else {
+        DFA_full_composition_helper(dfa_1, dfa_2);
+    }
+}
+
+void dfa::DFA_full_composition_helper(dfa& dfa_1, dfa& dfa_2) {
 
     int num_states_1 = dfa_1.num_states;
     int num_states_2 = dfa_2.num_states;
 
     int new_num_states = num_states_1 * num_states_2;
 
-    std::set<std::string> tmp_set;
-    tmp_set.insert(dfa_1.alphabet_symbols.begin(), dfa_1.alphabet_symbols.end());
-    tmp_set.insert(dfa_2.alphabet_symbols.begin(), dfa_2.alphabet_symbols.end());
-    auto new_alphabet_symbols = std::vector<std::string>(tmp_set.begin(), tmp_set.end());
-    int new_alph_size = new_alphabet_symbols.size();
+    auto new_alphabet = DFA_union_alphabet(dfa_1, dfa_2);
+    int new_alph_size = new_alphabet->symbols.size();
     auto new_final_states = std::vector<bool>( new_num_states, false);
     auto new_transition_matrix = std::vector<int>();
-    new_transition_matrix.resize(new_num_states * new_alph_size);
+    new_transition_matrix.resize((size_t) new_num_states * new_alph_size);
+
+    /* Resolve each symbol of the new alphabet against both inputs once */
+    auto symbol_map_1 = std::vector<int>(new_alph_size);
+    auto symbol_map_2 = std::vector<int>(new_alph_size);
+    for(int symb_ind = 0; symb_ind < new_alph_size; symb_ind++) {
+        symbol_map_1[symb_ind] = dfa_1.get_symbol_index(new_alphabet->symbols[symb_ind]);
+        symbol_map_2[symb_ind] = dfa_2.get_symbol_index(new_alphabet->symbols[symb_ind]);
+    }
 
     for(int s1 = 0; s1 < num_states_1; s1++) {
         for(int s2 = 0; s2 < num_states_2; s2++) {
             for(int symb_ind = 0; symb_ind < new_alph_size; symb_ind++) {
-                int s_ind1 = dfa_1.get_symbol_index(new_alphabet_symbols[symb_ind]);
-                int s_ind2 = dfa_2.get_symbol_index(new_alphabet_symbols[symb_ind]);
-                int M1_target = s_ind1 == DFA_INVALID_SYMBOL ? s1 : dfa_1.transition_matrix[s1][s_ind1];
-                int M2_target = s_ind2 == DFA_INVALID_SYMBOL ? s2 : dfa_2.transition_matrix[s2][s_ind2];
-                new_transition_matrix[(s1 * num_states_2 + s2) * new_alph_size + symb_ind] =
+                int s_ind1 = symbol_map_1[symb_ind];
+                int s_ind2 = symbol_map_2[symb_ind];
+                int M1_target = s_ind1 == DFA_INVALID_SYMBOL ? s1 : dfa_1.apply(s1, s_ind1);
+                int M2_target = s_ind2 == DFA_INVALID_SYMBOL ? s2 : dfa_2.apply(s2, s_ind2);
+                new_transition_matrix[(size_t) (s1 * num_states_2 + s2) * new_alph_size + symb_ind] =
                         (M1_target == DFA_DUMMY_SYMBOL || M2_target == DFA_DUMMY_SYMBOL) ?
                             DFA_DUMMY_SYMBOL : (M1_target * num_states_2 + M2_target);
             }
             if (dfa_1.final_states.count(s1) && dfa_2.final_states.count(s2)) {
-                new_final_states[s1 * num_states_1 + s2] = true;
+                new_final_states[s1 * num_states_2 + s2] = true;
+            }
+        }
+    }
+
+    DFA_constructor_helper(new_num_states,
+                dfa_1.initial_state * num_states_2 + dfa_2.initial_state,
+                new_final_states, new_alphabet,
+                new_transition_matrix.data());
+}
+
+void dfa::DFA_reachable_composition_helper(dfa& dfa_1, dfa& dfa_2) {
+    auto new_alphabet = DFA_union_alphabet(dfa_1, dfa_2);
+    int new_alph_size = new_alphabet->symbols.size();
+    auto symbol_map_1 = std::vector<int>(new_alph_size);
+    auto symbol_map_2 = std::vector<int>(new_alph_size);
+    for(int symb_ind = 0; symb_ind < new_alph_size; symb_ind++) {
+        symbol_map_1[symb_ind] = dfa_1.get_symbol_index(new_alphabet->symbols[symb_ind]);
+        symbol_map_2[symb_ind] = dfa_2.get_symbol_index(new_alphabet->symbols[symb_ind]);
+    }
+
+    /* Pairs are keyed as s1 * num_states_2 + s2 while expanding; states are numbered
+     * in discovery order, so rows are appended exactly in state order */
+    long long num_states_2 = dfa_2.num_states;
+    std::unordered_map<long long, int> pair_ids;
+    auto new_transition_matrix = std::vector<int>();
+    auto new_final_states = std::vector<bool>();
+    auto pairs = std::vector<std::pair<int, int>>();
+
+    pairs.emplace_back(dfa_1.initial_state, dfa_2.initial_state);
+    pair_ids.insert({dfa_1.initial_state * num_states_2 + dfa_2.initial_state, 0});
+    for(int current = 0; current < pairs.size(); current++) {
+        int s1 = pairs[current].first;
+        int s2 = pairs[current].second;
+        for(int symb_ind = 0; symb_ind < new_alph_size; symb_ind++) {
+            int s_ind1 = symbol_map_1[symb_ind];
+            int s_ind2 = symbol_map_2[symb_ind];
+            int M1_target = s_ind1 == DFA_INVALID_SYMBOL ? s1 : dfa_1.apply(s1, s_ind1);
+            int M2_target = s_ind2 == DFA_INVALID_SYMBOL ? s2 : dfa_2.apply(s2, s_ind2);
+            if (M1_target == DFA_DUMMY_SYMBOL || M2_target == DFA_DUMMY_SYMBOL) {
+                new_transition_matrix.push_back(DFA_DUMMY_SYMBOL);
+                continue;
+            }
+            auto inserted = pair_ids.insert({M1_target * num_states_2 + M2_target, (int) pairs.size()});
+            if (inserted.second) {
+                pairs.emplace_back(M1_target, M2_target);
             }
+            new_transition_matrix.push_back(inserted.first->second);
         }
+        new_final_states.push_back(dfa_1.final_states.count(s1) && dfa_2.final_states.count(s2));
     }
 
-    DFA_constructor_helper(new_num_states, new_alph_size, 0,
-                new_final_states, new_alphabet_symbols,
+    DFA_constructor_helper(pairs.size(), 0, new_final_states, new_alphabet,
                 new_transition_matrix.data());
+    this->component_states = std::move(pairs);
+}
+
+uint64_t dfa::DFA_hash() const {
+    /* FNV-1a over the structure, one 32-bit value at a time */
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](int value) {
+        hash ^= (uint32_t) value;
+        hash *= 0x100000001b3ULL;
+    };
+    mix(this->num_states);
+    mix(this->initial_state);
+    mix(this->alphabet_size);
+    for(int id : this->alphabet->symbols) mix(id);
+    for(int state : this->final_states) mix(state);
+    for(int target : this->transition_matrix) mix(target);
+    return hash;
+}
+
+bool dfa::DFA_equal(const dfa& other) const {
+    return this->num_states == other.num_states &&
+           this->initial_state == other.initial_state &&
+           this->alphabet->symbols == other.alphabet->symbols &&
+           this->final_states == other.final_states &&
+           this->transition_matrix == other.transition_matrix;
+}
+
+dfa_digest_t dfa::DFA_digest() const {
+    /* FNV-1a in the low lane and a multiply-rotate hash in the high lane */
+    dfa_digest_t digest = {0xcbf29ce484222325ULL, 0x9e3779b97f4a7c15ULL};
+    digest_mix(digest, this->num_states);
+    digest_mix(digest, this->initial_state);
+    digest_mix(digest, this->alphabet_size);
+    for(int id : this->alphabet->symbols) digest_mix(digest, id);
+    digest_mix(digest, this->final_states.size());
+    for(int state : this->final_states) digest_mix(digest, state);
+    for(int target : this->transition_matrix) digest_mix(digest, target);
+    digest_finish(digest);
+    return digest;
+}
+
+int dfa::DFA_equivalence_helper(const std::vector<int>& states, std::vector<int>& classes) const {
+    int alphabet_size = this->alphabet_size;
+
+    /* Hopcroft's algorithm over the given states, numbered locally in the order given.
+     * Undefined transitions lead to an extra sink state, which starts in a block of
+     * its own so that no given state can become equivalent to it */
+    std::vector<int> local(this->num_states, -1);
+    for(int i = 0; i < states.size(); i++) local[states[i]] = i;
+    bool partial = false;
+    for(int s : states) {
+        for(int a = 0; a < alphabet_size && !partial; a++) partial = this->apply(s, a) < 0;
+    }
+    int num_given = states.size();
+    int n = num_given + (partial ? 1 : 0);
+    int sink = partial ? num_given : -1;
+    auto successor = [&](int q, int a) {
+        if (q == sink) return sink;
+        int target = this->apply(states[q], a);
+        return target < 0 ? sink : local[target];
+    };
+
+    /* Predecessors of each (symbol, state) pair, grouped by symbol then state */
+    size_t num_pairs = (size_t) alphabet_size * n;
+    std::vector<size_t> pred_start(num_pairs + 1, 0);
+    for(int q = 0; q < n; q++) {
+        for(int a = 0; a < alphabet_size; a++) pred_start[(size_t) a * n + successor(q, a) + 1]++;
+    }
+    for(size_t i = 0; i < num_pairs; i++) pred_start[i + 1] += pred_start[i];
+    std::vector<int> preds(pred_start.back());
+    std::vector<size_t> fill(pred_start.begin(), pred_start.end() - 1);
+    for(int q = 0; q < n; q++) {
+        for(int a = 0; a < alphabet_size; a++) preds[fill[(size_t) a * n + successor(q, a)]++] = q;
+    }
+
+    /* Refinable partition: the states of block b are elements[first[b], end[b]), and
+     * the first marked[b] of them are marked by the current splitter */
+    std::vector<int> elements(n), position(n), block(n);
+    std::vector<int> first, end, marked;
+    auto add_block = [&](int from, int to) {
+        first.push_back(from);
+        end.push_back(to);
+        marked.push_back(0);
+        for(int i = from; i < to; i++) block[elements[i]] = first.size() - 1;
+    };
+    int count = 0;
+    for(int pass = 0; pass < 3; pass++) {
+        int from = count;
+        for(int q = 0; q < n; q++) {
+            int kind = q == sink ? 2 : (this->final_states.count(states[q]) ? 1 : 0);
+            if (kind != pass) continue;
+            position[q] = count;
+            elements[count++] = q;
+        }
+        if (count > from) add_block(from, count);
+    }
+
+    /* Every (block, symbol) pair starts out as a splitter */
+    std::vector<std::pair<int, int>> splitters;
+    std::vector<char> pending;
+    for(int b = 0; b < first.size(); b++) {
+        for(int a = 0; a < alphabet_size; a++) {
+            splitters.emplace_back(b, a);
+            pending.push_back(1);
+        }
+    }
+
+    std::vector<int> splitter_states, touched;
+    while (!splitters.empty()) {
+        int splitter = splitters.back().first;
+        int a = splitters.back().second;
+        splitters.pop_back();
+        pending[(size_t) splitter * alphabet_size + a] = 0;
+
+        /* Mark every predecessor on a of a state in the splitter */
+        splitter_states.assign(elements.begin() + first[splitter], elements.begin() + end[splitter]);
+        touched.clear();
+        for(int t : splitter_states) {
+            for(size_t i = pred_start[(size_t) a * n + t]; i < pred_start[(size_t) a * n + t + 1]; i++) {
+                int q = preds[i];
+                int b = block[q];
+                int marked_end = first[b] + marked[b];
+                if (position[q] < marked_end) continue;
+                if (marked[b] == 0) touched.push_back(b);
+                int other = elements[marked_end];
+                std::swap(elements[position[q]], elements[marked_end]);
+                position[other] = position[q];
+                position[q] = marked_end;
+                marked[b]++;
+            }
+        }
+
+        /* Split each touched block into its marked and unmarked states */
+        for(int b : touched) {
+            int num_marked = marked[b];
+            marked[b] = 0;
+            if (num_marked == end[b] - first[b]) continue;
+            int split_at = first[b] + num_marked;
+            add_block(first[b], split_at);
+            first[b] = split_at;
+            int new_block = first.size() - 1;
+            for(int c = 0; c < alphabet_size; c++) {
+                pending.push_back(0);
+                int smaller = num_marked <= end[b] - first[b] ? new_block : b;
+                if (pending[(size_t) b * alphabet_size + c]) smaller = new_block;
+                pending[(size_t) smaller * alphabet_size + c] = 1;
+                splitters.emplace_back(smaller, c);
+            }
+        }
+    }
+
+    classes.assign(this->num_states, -1);
+    for(int q = 0; q < num_given; q++) classes[states[q]] = block[q];
+    /* Keep class numbers dense by giving the sink's block the last number */
+    int num_classes = first.size() - (partial ? 1 : 0);
+    if (partial && block[sink] != num_classes) {
+        for(int q = 0; q < num_given; q++) {
+            if (classes[states[q]] == num_classes) classes[states[q]] = block[sink];
+        }
+    }
+    return num_classes;
+}
+
+int dfa::DFA_canonical_helper(std::vector<int>& transitions, std::vector<bool>& finals,
+        std::vector<int> *mapping) const {
+    int alphabet_size = this->alphabet_size;
+
+    /* Reachable states, which are closed under transitions */
+    std::vector<int> reachable = {this->initial_state};
+    std::vector<char> seen(this->num_states, 0);
+    seen[this->initial_state] = 1;
+    for(int i = 0; i < reachable.size(); i++) {
+        for(int a = 0; a < alphabet_size; a++) {
+            int target = this->apply(reachable[i], a);
+            if (target >= 0 && !seen[target]) {
+                seen[target] = 1;
+                reachable.push_back(target);
+            }
+        }
+    }
+
+    std::vector<int> classes;
+    int num_classes = this->DFA_equivalence_helper(reachable, classes);
+
+    /* Number the classes in breadth-first order, starting from the initial state's */
+    std::vector<int> number(num_classes, -1);
+    std::vector<int> representatives = {this->initial_state};
+    number[classes[this->initial_state]] = 0;
+    transitions.clear();
+    finals.clear();
+    for(int i = 0; i < representatives.size(); i++) {
+        int s = representatives[i];
+        for(int a = 0; a < alphabet_size; a++) {
+            int target = this->apply(s, a);
+            if (target < 0) {
+                transitions.push_back(DFA_DUMMY_SYMBOL);
+                continue;
+            }
+            if (number[classes[target]] < 0) {
+                number[classes[target]] = representatives.size();
+                representatives.push_back(target);
+            }
+            transitions.push_back(number[classes[target]]);
+        }
+        finals.push_back(this->final_states.count(s) > 0);
+    }
+    if (mapping != nullptr) {
+        mapping->assign(this->num_states, -1);
+        for(int s : reachable) (*mapping)[s] = number[classes[s]];
+    }
+    return num_classes;
+}
+
+dfa *dfa::DFA_canonical() const {
+    return this->DFA_minimize(nullptr);
+}
+
+dfa *dfa::DFA_minimize(std::vector<int> *mapping) const {
+    std::vector<int> transitions;
+    std::vector<bool> finals;
+    int num_states = this->DFA_canonical_helper(transitions, finals, mapping);
+    return new dfa(num_states, 0, finals, this->alphabet, transitions.data());
+}
+
+dfa_digest_t dfa::DFA_canonical_digest() const {
+    std::vector<int> transitions;
+    std::vector<bool> finals;
+    int num_states = this->DFA_canonical_helper(transitions, finals, nullptr);
+
+    /* Same as DFA_digest() of the canonical form, without building it */
+    dfa_digest_t digest = {0xcbf29ce484222325ULL, 0x9e3779b97f4a7c15ULL};
+    digest_mix(digest, num_states);
+    digest_mix(digest, 0);
+    digest_mix(digest, this->alphabet_size);
+    for(int id : this->alphabet->symbols) digest_mix(digest, id);
+    digest_mix(digest, std::count(finals.begin(), finals.end(), true));
+    for(int state = 0; state < num_states; state++) {
+        if (finals[state]) digest_mix(digest, state);
+    }
+    for(int target : transitions) digest_mix(digest, target);
+    digest_finish(digest);
+    return digest;
 }
 
 void dfa::DFA_print(FILE *f) const {
-    int alphabet_size = this->alphabet_symbols.size();
+    int alphabet_size = this->alphabet_size;
     fprintf(f, "Num states: %d; Alphabet size %d\n", this->num_states, alphabet_size);
     fprintf(f, "Initial state: %d\n", this->initial_state);
     fprintf(f, "Final state(s): ");
@@ -223,10 +521,10 @@ void dfa::DFA_print(FILE *f) const {
     }
     fprintf(f, "\nAlphabet Symbol(s): \n");
     for(int i = 0; i < alphabet_size; i++) {
-        fprintf(f, "%d - %s\n", i, this->alphabet_symbols[i].c_str());
+        fprintf(f, "%d - %s\n", i, this->get_symbol_name(i).c_str());
     }
     fprintf(f, "\nTransition Matrix:\n");
-    vec_2d_print(this->transition_matrix, f);
+    vec_2d_print(this->transition_matrix, alphabet_size, f);
 }
 
 int dfa::DFA_apply_symbol(int current_state, const std::string& symbol) {
@@ -235,58 +533,48 @@ int dfa::DFA_apply_symbol(int current_state, const std::string& symbol) {
     if ((symbol_index = this->get_symbol_index(symbol)) < 0) {
         return DFA_INVALID_SYMBOL;
     }
-    return this->transition_matrix[current_state][symbol_index];
+    return this->apply(current_state, symbol_index);
 }
 
-dfa::dfa(dfa& source) {
+dfa::dfa(const dfa& source) {
     this->num_states = source.num_states;
     this->initial_state = source.initial_state;
+    this->alphabet_size = source.alphabet_size;
     this->final_states = std::set<int>(source.final_states);
-    this->alphabet_symbols = std::vector<std::string>(source.alphabet_symbols);
-    this->transition_matrix = std::vector<std::vector<int>>();
-    this->transition_matrix.resize(source.transition_matrix.size());
-    for(int i = 0; i < source.transition_matrix.size(); i++) {
-        this->transition_matrix[i] = std::vector<int>(source.transition_matrix[i]);
+    this->alphabet = source.alphabet;
+    this->transition_matrix = std::vector<int>(source.transition_matrix);
+    this->component_states = source.component_states;
+}
+
+std::shared_ptr<const dfa_alphabet> DFA_union_alphabet(const dfa& dfa_1, const dfa& dfa_2) {
+    auto ids = std::vector<int>(dfa_1.alphabet->symbols);
+    for(int id : dfa_2.alphabet->symbols) {
+        if (dfa_1.get_symbol_index(id) == DFA_INVALID_SYMBOL) ids.push_back(id);
     }
+    std::sort(ids.begin(), ids.end(), [](int a, int b) {
+        return symbol_name(a) < symbol_name(b);
+    });
+    return std::make_shared<const dfa_alphabet>(ids);
 }
 
-static void vec_2d_print(const std::vector<std::vector<int>>& v, FILE *f) {
-    for(const auto & i : v) {
-        for(int j : i) {
-            fprintf(f, "%d ", j);
+static void vec_2d_print(const std::vector<int>& v, int cols, FILE *f) {
+    for(int i = 0; cols > 0 && i < v.size(); i += cols) {
+        for(int j = i; j < i + cols; j++) {
+            fprintf(f, "%d ", v[j]);
         }
         fprintf(f, "\n");
     }
 }
 
-
-static bool vec_contains_duplicates(std::vector<int>& v) {
-    std::set<int> s(v.begin(), v.end());
-    return s.size() != v.size();
-}
-
-static int vec_index_of(std::vector<int>& v, int val) {
-    auto it = std::find(v.begin(), v.end(), val);
-    if (it == v.end()) return -1;
-    else return std::distance(v.begin(), it);
+static inline void digest_mix(dfa_digest_t& digest, uint32_t value) {
+    digest.low ^= value;
+    digest.low *= 0x100000001b3ULL;
+    digest.high ^= value * 0xc4ceb9fe1a85ec53ULL;
+    digest.high = ((digest.high << 31) | (digest.high >> 33)) * 0x9e3779b97f4a7c15ULL;
 }
 
-static int get_next_permutation(std::vector<int>& current_permutation, int max_value) {
-    int length = current_permutation.size();
-
-    start_of_loop:
-    for(int i = length - 1; i >= 0; i--) {
-        int new_val = current_permutation[i]++;
-        if (new_val == max_value) {
-            current_permutation[i] = 0;
-            continue;
-        }
-        if (vec_contains_duplicates(current_permutation)) {
-            goto start_of_loop;
-        } else {
-            return 0;
-        }
-    }
-    return -1;
+static inline void digest_finish(dfa_digest_t& digest) {
+    digest.high ^= digest.high >> 33;
+    digest.high *= 0xff51afd7ed558ccdULL;
+    digest.high ^= digest.high >> 33;
 }
-
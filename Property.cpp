@@ -5,9 +5,62 @@
  *  Detailed Documentation in header file
  */
 #include "inc/Property.h"
+#include "inc/symbol_table.h"
 #include <iostream>
-#include <queue>
-#include <boost/unordered_set.hpp>
+#include <cstdint>
+#include <mutex>
+
+/* Symbols of a composition of two DFAs with a property */
+typedef struct composition_symbols {
+    std::shared_ptr<const dfa_alphabet> alphabet_1;    /* Alphabet of the first DFA */
+    std::shared_ptr<const dfa_alphabet> alphabet_2;    /* Alphabet of the second DFA */
+    std::shared_ptr<const dfa_alphabet> alphabet;      /* Union of the two */
+    std::vector<int> symbols_1;     /* Index of each union symbol in the first DFA, or
+                                     * DFA_INVALID_SYMBOL */
+    std::vector<int> symbols_2;     /* Same for the second DFA */
+    std::vector<int> prop_symbols;  /* Same for the property */
+} composition_symbols_t;
+
+struct composition_cache {
+    std::mutex lock;                /* Guards last */
+    std::shared_ptr<const composition_symbols_t> last; /* Composition checked last */
+};
+
+/** @brief Returns the symbols of the composition of two DFAs with a property, only
+ *      building them when the alphabets differ from the last composition's
+ *
+ * Building the union alphabet looks up symbol names under the symbol table's lock,
+ * which checks running on several threads would otherwise all wait for.
+ *
+ * @param cache Cache of the property
+ * @param M1 First DFA
+ * @param M2 Second DFA
+ * @param prop_dfa DFA of the property
+ * @return Symbols of the composition
+ */
+static std::shared_ptr<const composition_symbols_t> composition_find(composition_cache &cache,
+        const dfa &M1, const dfa &M2, const dfa &prop_dfa);
+
+/* *****     IMPLEMENTATION     ***** */
+
+static std::shared_ptr<const composition_symbols_t> composition_find(composition_cache &cache,
+        const dfa &M1, const dfa &M2, const dfa &prop_dfa) {
+    std::lock_guard<std::mutex> guard(cache.lock);
+    if (cache.last && cache.last->alphabet_1 == M1.alphabet && cache.last->alphabet_2 == M2.alphabet) {
+        return cache.last;
+    }
+    std::shared_ptr<composition_symbols_t> found = std::make_shared<composition_symbols_t>();
+    found->alphabet_1 = M1.alphabet;
+    found->alphabet_2 = M2.alphabet;
+    found->alphabet = DFA_union_alphabet(M1, M2);
+    for (int symbol_id : found->alphabet->symbols) {
+        found->symbols_1.push_back(M1.get_symbol_index(symbol_id));
+        found->symbols_2.push_back(M2.get_symbol_index(symbol_id));
+        found->prop_symbols.push_back(prop_dfa.get_symbol_index(symbol_id));
+    }
+    cache.last = found;
+    return found;
+}
 
 
 Property::Property(dfa& dfa, interps_t mode,
@@ -15,6 +68,42 @@ Property::Property(dfa& dfa, interps_t mode,
     this->sim_dfa = &dfa;
     this->invalid_interp = mode;
     this->error_states.insert(error_states, error_states + num_error_states);
+    this->error_lookup.assign(dfa.num_states, false);
+    for (int s : this->error_states) {
+        if (s >= 0 && s < dfa.num_states) this->error_lookup[s] = true;
+    }
+
+    /* Backward search from the error states over every transition of the property */
+    std::vector<std::vector<int>> preds(dfa.num_states);
+    for (int s = 0; s < dfa.num_states; s++) {
+        for (int symb_ind = 0; symb_ind < dfa.alphabet_size; symb_ind++) {
+            int t = dfa.apply(s, symb_ind);
+            if (t >= 0 && t != s) preds[t].push_back(s);
+        }
+    }
+    this->coreachable = this->error_lookup;
+    std::vector<int> queue;
+    for (int s = 0; s < dfa.num_states; s++) {
+        if (this->coreachable[s]) queue.push_back(s);
+    }
+    for (int i = 0; i < queue.size(); i++) {
+        for (int s : preds[queue[i]]) {
+            if (!this->coreachable[s]) {
+                this->coreachable[s] = true;
+                queue.push_back(s);
+            }
+        }
+    }
+    this->engine = check_engine::BFS;
+    this->compositions = std::make_shared<composition_cache>();
+}
+
+void Property::set_engine(check_engine_t engine) {
+    this->engine = engine;
+    if (engine == check_engine::BITSET && !this->bitset) {
+        this->bitset.reset(new bitset_checker(*this->sim_dfa, this->error_lookup, true,
+                &this->coreachable));
+    }
 }
 
 void Property::property_print() {
@@ -25,60 +114,167 @@ void Property::property_print() {
     std::cout << std::endl;
 }
 
-typedef struct {
-    int dfa_state;
-    int prop_state;
-} check_state;
-typedef boost::unordered_set<check_state> unordered_set;
-bool operator==(const check_state &lhs, const check_state &rhs) {
-    return lhs.dfa_state == rhs.dfa_state && lhs.prop_state == rhs.prop_state;
-}
-std::size_t hash_value(const check_state &a) {
-    std::size_t seed = 0;
-    boost::hash_combine(seed, a.dfa_state);
-    boost::hash_combine(seed, a.prop_state);
-    return seed;
+bool Property::property_check(dfa &M) {
+    return this->property_check(M, this->workspace);
 }
 
-bool Property::property_check(dfa &M) {
-    std::vector<std::string> valid_symbols = M.alphabet_symbols;
-    int alphabet_size = M.alphabet_symbols.size();
+bool Property::property_check(dfa &M, check_workspace &workspace, counterexample_t *trace) {
+    if (!this->can_be_violated()) {
+        return true;
+    }
+    int alphabet_size = M.alphabet_size;
     dfa *prop_dfa = this->sim_dfa;
 
-    int alarm_status;
+    /* Align the alphabet of M against the property's up front so that the
+     * search itself only works with symbol indexes */
+    std::vector<int> prop_symbols = M.DFA_align_alphabet(*prop_dfa);
+    if (this->engine == check_engine::BITSET && trace == nullptr) {
+        std::vector<int> dfa_symbols(alphabet_size);
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) dfa_symbols[symb_ind] = symb_ind;
+        return this->bitset->check(M, dfa_symbols, prop_symbols, workspace);
+    }
 
-    std::queue<check_state*> todo_list;
-    auto *first = new check_state;
-    first->dfa_state = M.initial_state;
-    first->prop_state = prop_dfa->initial_state;
-    todo_list.push(first);
+    /* Product states are packed into a single key as dfa_state * |P| + prop_state */
+    uint64_t num_prop_states = prop_dfa->num_states;
+    workspace.reset((uint64_t) M.num_states * num_prop_states, trace != nullptr);
+    uint64_t first = M.initial_state * num_prop_states + prop_dfa->initial_state;
+    workspace.visit(first);
+    workspace.push(first);
 
-    unordered_set visited_states;
-    visited_states.insert({M.initial_state, prop_dfa->initial_state});
+    while(!workspace.empty()) {
+        uint64_t current = workspace.pop();
+        int dfa_state = current / num_prop_states;
+        int prop_state = current % num_prop_states;
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            int next_dfa_state = M.apply(dfa_state, symb_ind);
+            if (next_dfa_state == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+            int next_prop_state = prop_symbols[symb_ind] < 0 ? DFA_INVALID_SYMBOL :
+                    prop_dfa->apply(prop_state, prop_symbols[symb_ind]);
+            if (next_prop_state < 0) {
+                next_prop_state = prop_state;
+            }
+            uint64_t next = next_dfa_state * num_prop_states + next_prop_state;
+            if (this->error_lookup[next_prop_state]) {
+                if (trace != nullptr) {
+                    counterexample_build(workspace, {(uint64_t) M.num_states, num_prop_states},
+                            M.alphabet->symbols, symb_ind, next, trace);
+                }
+                return false;
+            }
+            if (!this->coreachable[next_prop_state]) {
+                continue;
+            }
+            if (workspace.visit(next)) {
+                workspace.push(next, symb_ind);
+            }
+        }
+    }
+    return true;
+}
+
+bool Property::property_check(dfa &M1, dfa &M2) {
+    return this->property_check(M1, M2, this->workspace);
+}
+
+bool Property::property_check(dfa &M1, dfa &M2, check_workspace &workspace,
+        counterexample_t *trace) {
+    if (!this->can_be_violated()) {
+        return true;
+    }
+    dfa *prop_dfa = this->sim_dfa;
+    std::shared_ptr<const composition_symbols_t> composition =
+            composition_find(*this->compositions, M1, M2, *prop_dfa);
+    const std::vector<int> &symbols_1 = composition->symbols_1;
+    const std::vector<int> &symbols_2 = composition->symbols_2;
+    const std::vector<int> &prop_symbols = composition->prop_symbols;
+    int alphabet_size = composition->alphabet->symbols.size();
 
-    bool result = true;
+    /* Tuples are packed into a single key as (s1 * |M2| + s2) * |P| + p */
+    uint64_t num_states_2 = M2.num_states;
+    uint64_t num_prop_states = prop_dfa->num_states;
+    workspace.reset((uint64_t) M1.num_states * num_states_2 * num_prop_states, trace != nullptr);
+    uint64_t first = (M1.initial_state * num_states_2 + M2.initial_state) * num_prop_states +
+            prop_dfa->initial_state;
+    workspace.visit(first);
+    workspace.push(first);
 
-    while(!todo_list.empty()) {
-        check_state *current = todo_list.front();
-        todo_list.pop();
-        visited_states.insert({current->dfa_state, current->prop_state});
+    while(!workspace.empty()) {
+        uint64_t current = workspace.pop();
+        int p = current % num_prop_states;
+        int s2 = (current / num_prop_states) % num_states_2;
+        int s1 = (current / num_prop_states) / num_states_2;
         for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
-            auto *ck = new check_state;
-            ck->dfa_state = M.DFA_apply_symbol(current->dfa_state, valid_symbols[symb_ind]);
-            ck->prop_state = prop_dfa->DFA_apply_symbol(current->prop_state, valid_symbols[symb_ind]);
-            if (ck->prop_state < 0) {
-                ck->prop_state = current->prop_state;
-            }
-            if (ck->dfa_state == DFA_DUMMY_SYMBOL) {
+            int t1 = symbols_1[symb_ind] < 0 ? s1 : M1.apply(s1, symbols_1[symb_ind]);
+            int t2 = symbols_2[symb_ind] < 0 ? s2 : M2.apply(s2, symbols_2[symb_ind]);
+            if (t1 == DFA_DUMMY_SYMBOL || t2 == DFA_DUMMY_SYMBOL) {
                 continue;
-            } else if (this->error_states.find(ck->prop_state) != this->error_states.end()) {
-                return false;
-            } else {
-                if (visited_states.find({ck->dfa_state, ck->prop_state}) == visited_states.end()) {
-                    todo_list.push(ck);
+            }
+            int tp = prop_symbols[symb_ind] < 0 ? DFA_INVALID_SYMBOL :
+                    prop_dfa->apply(p, prop_symbols[symb_ind]);
+            if (tp < 0) {
+                tp = p;
+            }
+            uint64_t next = (t1 * num_states_2 + t2) * num_prop_states + tp;
+            if (this->error_lookup[tp]) {
+                if (trace != nullptr) {
+                    counterexample_build(workspace, {(uint64_t) M1.num_states, num_states_2,
+                            num_prop_states}, composition->alphabet->symbols, symb_ind, next, trace);
                 }
+                return false;
+            }
+            if (!this->coreachable[tp]) {
+                continue;
+            }
+            if (workspace.visit(next)) {
+                workspace.push(next, symb_ind);
             }
         }
     }
-    return result;
+    return true;
+}
+
+void counterexample_build(const check_workspace &workspace, const std::vector<uint64_t> &sizes,
+        const std::vector<int> &symbol_ids, int symbol, uint64_t error_key, counterexample_t *trace) {
+    std::vector<uint64_t> keys;
+    std::vector<int> symbols;
+    workspace.trace_back(keys, symbols);
+    keys.push_back(error_key);
+    symbols.push_back(symbol);
+
+    trace->symbols.clear();
+    for (int symb_ind : symbols) trace->symbols.push_back(symbol_ids[symb_ind]);
+    int num_components = sizes.size();
+    trace->states.assign(num_components, std::vector<int>(keys.size()));
+    for (int i = 0; i < keys.size(); i++) {
+        uint64_t key = keys[i];
+        for (int c = num_components - 1; c >= 0; c--) {
+            trace->states[c][i] = key % sizes[c];
+            key /= sizes[c];
+        }
+    }
+}
+
+void counterexample_replay(counterexample_t *trace, int component, const dfa &M) {
+    std::vector<int> &states = trace->states[component];
+    states[0] = M.initial_state;
+    for (int i = 0; i < trace->symbols.size(); i++) {
+        int symb_ind = M.get_symbol_index(trace->symbols[i]);
+        states[i + 1] = symb_ind < 0 ? states[i] : M.apply(states[i], symb_ind);
+    }
+}
+
+void counterexample_print(const counterexample_t &trace, FILE *f) {
+    int num_components = trace.states.size();
+    fprintf(f, "Counterexample: %d step(s)\n", (int) trace.symbols.size());
+    for (int i = 0; i <= trace.symbols.size(); i++) {
+        if (i == 0) fprintf(f, "  ");
+        else fprintf(f, "  %s -> ", symbol_name(trace.symbols[i - 1]).c_str());
+        fprintf(f, "(");
+        for (int c = 0; c < num_components; c++) {
+            fprintf(f, c == 0 ? "%d" : ", %d", trace.states[c][i]);
+        }
+        fprintf(f, ")\n");
+    }
 }
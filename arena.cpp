@@ -0,0 +1,39 @@
+/** @file arena.cpp
+ *  @brief Bump allocation of short-lived arrays
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include "inc/arena.h"
+
+/* *****     IMPLEMENTATION     ***** */
+
+arena::arena() {
+    this->used = 0;
+}
+
+char *arena::grow(size_t bytes) {
+    size_t size = this->sizes.empty() ? ARENA_INITIAL_SIZE : 2 * this->sizes.back();
+    size = std::max(size, bytes);
+    this->blocks.emplace_back(new char[size]);
+    this->sizes.push_back(size);
+    this->used = bytes;
+    return this->blocks.back().get();
+}
+
+void arena::reset() {
+    this->used = 0;
+    if (this->blocks.size() <= 1) {
+        return;
+    }
+
+    /* Merge the blocks, so the same workload fits in the first one next time */
+    size_t total = 0;
+    for (size_t size : this->sizes) total += size;
+    this->blocks.clear();
+    this->sizes.clear();
+    this->blocks.emplace_back(new char[total]);
+    this->sizes.push_back(total);
+}
@@ -0,0 +1,166 @@
+/** @file batch_check.cpp
+ *  @brief Checking many mutants of one DFA together
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include <cassert>
+#include "inc/batch_check.h"
+
+/* Initial number of slots of a search's pair table, a power of two */
+#define BATCH_INITIAL_SLOTS (1 << 10)
+
+/* Lane masks of a pair reached by a batched search */
+typedef struct batch_slot {
+    uint64_t key;       /* Packed key of the pair plus one, 0 for an empty slot */
+    uint64_t reached;   /* Lanes in which the pair is reachable */
+    uint64_t pending;   /* Lanes the pair has yet to pass on */
+} batch_slot_t;
+
+/* Open-addressing table of the pairs a batched search has reached, allocated
+ * from the workspace's arena so that it is released by the next reset */
+typedef struct batch_table {
+    batch_slot_t *slots;    /* Slots; the number is a power of two */
+    uint64_t size;          /* Number of slots */
+    uint64_t count;         /* Number of filled slots */
+} batch_table_t;
+
+/** @brief Finds the slot of a pair, adding an empty one if it was not reached yet
+ *
+ * Adding a pair may move every slot, so earlier pointers into the table must not
+ * be used afterwards.
+ *
+ * @param table Table of the search
+ * @param key Packed key of the pair
+ * @param workspace Workspace whose arena the table grows into
+ * @return Slot of the pair
+ */
+static batch_slot_t *batch_find(batch_table_t &table, uint64_t key, check_workspace &workspace);
+
+/* *****     IMPLEMENTATION     ***** */
+
+static batch_slot_t *batch_find(batch_table_t &table, uint64_t key, check_workspace &workspace) {
+    uint64_t mask = table.size - 1;
+    uint64_t pos = workspace_hash(key) & mask;
+    for (; table.slots[pos].key != 0; pos = (pos + 1) & mask) {
+        if (table.slots[pos].key == key + 1) return &table.slots[pos];
+    }
+    /* Keep the load factor at or below one half */
+    if ((table.count + 1) * 2 > table.size) {
+        batch_slot_t *old_slots = table.slots;
+        uint64_t old_size = table.size;
+        table.size *= 2;
+        table.slots = workspace.allocate<batch_slot_t>(table.size);
+        std::fill_n(table.slots, table.size, batch_slot_t{0, 0, 0});
+        mask = table.size - 1;
+        for (uint64_t i = 0; i < old_size; i++) {
+            if (old_slots[i].key == 0) continue;
+            uint64_t to = workspace_hash(old_slots[i].key - 1) & mask;
+            while (table.slots[to].key != 0) to = (to + 1) & mask;
+            table.slots[to] = old_slots[i];
+        }
+        pos = workspace_hash(key) & mask;
+        while (table.slots[pos].key != 0) pos = (pos + 1) & mask;
+    }
+    table.count++;
+    table.slots[pos] = batch_slot_t{key + 1, 0, 0};
+    return &table.slots[pos];
+}
+
+batch_checker::batch_checker(const monitored_machine& monitor, const dfa& base)
+        : monitor(monitor), base(base) {
+    this->alignment = monitor.align(base);
+}
+
+uint64_t batch_checker::check(const std::vector<const dfa_mutant*>& mutants, check_workspace& workspace) const {
+    int num_lanes = mutants.size();
+    assert(num_lanes <= BATCH_MAX_LANES);
+    if (num_lanes == 0) {
+        return 0;
+    }
+    const dfa& base = this->base;
+    const dfa& monitor_dfa = *this->monitor.product;
+    int num_symbols = this->alignment.human_symbols.size();
+    uint64_t num_monitor_states = monitor_dfa.num_states;
+
+    /* Only the frontier and temporary arrays of the workspace are used, so its
+     * visited set is left empty */
+    workspace.reset(0);
+
+    /* Lanes in which each base state's row may have changed */
+    uint64_t *touched = workspace.allocate<uint64_t>(base.num_states);
+    std::fill_n(touched, base.num_states, 0);
+    for (int lane = 0; lane < num_lanes; lane++) {
+        assert(&mutants[lane]->get_base() == &base);
+        for (int h : mutants[lane]->touched_states()) touched[h] |= 1ULL << lane;
+    }
+
+    /* Lane masks of the pairs reached so far; pairs are packed into a single key
+     * as human_state * |monitor| + monitor_state */
+    batch_table_t table;
+    table.size = BATCH_INITIAL_SLOTS;
+    table.count = 0;
+    table.slots = workspace.allocate<batch_slot_t>(table.size);
+    std::fill_n(table.slots, table.size, batch_slot_t{0, 0, 0});
+
+    uint64_t active = num_lanes == 64 ? ~0ULL : (1ULL << num_lanes) - 1;
+    uint64_t first = base.initial_state * num_monitor_states + monitor_dfa.initial_state;
+    batch_slot_t *first_slot = batch_find(table, first, workspace);
+    first_slot->reached = active;
+    first_slot->pending = active;
+    workspace.push(first);
+
+    while (!workspace.empty() && active != 0) {
+        uint64_t current = workspace.pop();
+        batch_slot_t *current_slot = batch_find(table, current, workspace);
+        uint64_t lanes = current_slot->pending & active;
+        current_slot->pending = 0;
+        if (lanes == 0) {
+            continue;
+        }
+        int h = current / num_monitor_states;
+        int m = current % num_monitor_states;
+        uint64_t shared = lanes & ~touched[h];
+        uint64_t changed = lanes & touched[h];
+        for (int k = 0; k < num_symbols && active != 0; k++) {
+            int h_symbol = this->alignment.human_symbols[k];
+            int m_symbol = this->alignment.monitor_symbols[k];
+            int m_target = m_symbol < 0 ? m : monitor_dfa.apply(m, m_symbol);
+            if (m_target == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+
+            /* Unchanged lanes move together; changed ones each follow their own row */
+            uint64_t group = shared;
+            int h_target = h_symbol < 0 ? h : base.apply(h, h_symbol);
+            uint64_t remaining = changed;
+            while (true) {
+                group &= active;
+                if (group != 0 && h_target != DFA_DUMMY_SYMBOL) {
+                    if (this->monitor.error[m_target]) {
+                        active &= ~group;
+                    } else {
+                        uint64_t next = h_target * num_monitor_states + m_target;
+                        batch_slot_t *slot = batch_find(table, next, workspace);
+                        uint64_t added = group & ~slot->reached;
+                        if (added != 0) {
+                            slot->reached |= added;
+                            if (slot->pending == 0) workspace.push(next);
+                            slot->pending |= added;
+                        }
+                    }
+                }
+                if (remaining == 0) {
+                    break;
+                }
+                int lane = __builtin_ctzll(remaining);
+                remaining &= remaining - 1;
+                group = 1ULL << lane;
+                h_target = h_symbol < 0 ? h : mutants[lane]->apply(h, h_symbol);
+            }
+        }
+    }
+    return active;
+}
@@ -0,0 +1,277 @@
+/** @file bench.cpp
+ *  @brief Benchmarks of the core operations on generated DFAs
+ *  @author Brian Wei
+ *
+ *  Times DFA_find_pattern, parallel composition, Property::property_check (on
+ *  both its breadth-first and bitset engines), several properties checked one by
+ *  one and as a PropertySet, and full modify_violate_property campaigns (with
+ *  incremental and with batched checks) over random, ring and pump DFAs of
+ *  growing size (see examples.h), and prints the results as JSON on standard
+ *  out.  Each result reports the time per operation, the states of the input
+ *  model (or, for composition, of the product) handled per second, and the
+ *  peak resident set size of the process so far.
+ *
+ *  Usage: Verif_bench [--quick] [--threads n]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+
+#include "inc/DFA.h"
+#include "inc/batch_check.h"
+#include "inc/examples.h"
+#include "inc/Property.h"
+#include "inc/property_set.h"
+#include "inc/modify.h"
+#include "inc/pattern_lib.h"
+
+/* Minimum time spent repeating each operation, in seconds */
+#define BENCH_MIN_SECONDS       (0.2)
+#define BENCH_QUICK_SECONDS     (0.02)
+
+/* Number of states of the machine composed with every generated model */
+#define BENCH_PARTNER_STATES    (16)
+
+/* Number of states of the property, whose last state is an unreachable error */
+#define BENCH_PROPERTY_STATES   (8)
+
+/* Number of properties checked together against the composition */
+#define BENCH_SET_PROPERTIES    (8)
+
+/* Limit on the number of trials per map of a campaign */
+#define BENCH_CAMPAIGN_TRIALS   (16)
+
+/* Generated model that the benchmarks run on */
+typedef struct bench_model {
+    std::string generator;      /* Name of the generator */
+    dfa *model;                 /* Generated DFA */
+    double density;             /* Fraction of defined transitions */
+} bench_model_t;
+
+/** @brief Generates a model
+ *
+ * @param generator One of "random", "ring" or "pump"
+ * @param size Number of states
+ * @param alphabet_size Number of symbols
+ * @param density Probability of a transition being defined, only used for random
+ * @param seed Seed of the generator, only used for random
+ * @return Pointer to the new DFA
+ */
+static dfa *bench_generate(const std::string &generator, int size, int alphabet_size,
+        double density, unsigned seed);
+
+/** @brief Generates a property which no model can violate, so checks explore the
+ *      whole reachable product
+ *
+ * @param alphabet_size Number of symbols
+ * @param seed Seed of the generator
+ * @return Pointer to the new property DFA, whose last state is the error state
+ */
+static dfa *bench_property(int alphabet_size, unsigned seed);
+
+/** @brief Repeats an operation until enough time has passed
+ *
+ * @param op Operation to repeat
+ * @param min_seconds Minimum total time
+ * @param iterations Where to store the number of repetitions
+ * @return Mean time per operation, in nanoseconds
+ */
+static double bench_time(const std::function<void()> &op, double min_seconds, long long &iterations);
+
+/** @brief Returns the peak resident set size of the process
+ *
+ * @return Peak resident set size, in kilobytes
+ */
+static long bench_peak_rss_kb();
+
+/** @brief Prints one benchmark result as a JSON object
+ *
+ * @param first Whether this is the first result printed
+ * @param name Name of the benchmarked operation
+ * @param m Model the operation ran on
+ * @param iterations Number of repetitions
+ * @param ns_per_op Mean time per operation, in nanoseconds
+ * @param states Number of states handled by one operation
+ */
+static void bench_print(bool first, const char *name, const bench_model_t &m,
+        long long iterations, double ns_per_op, long long states);
+
+/* *****     IMPLEMENTATION     ***** */
+
+int main(int argc, char **argv) {
+    bool quick = false;
+    int num_threads = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--threads n]\n", argv[0]);
+            return 1;
+        }
+    }
+    double min_seconds = quick ? BENCH_QUICK_SECONDS : BENCH_MIN_SECONDS;
+    std::vector<int> sizes = quick ? std::vector<int>({64, 256}) :
+            std::vector<int>({64, 256, 1024, 4096});
+    std::vector<int> alphabet_sizes = {2, 8};
+    std::vector<std::pair<std::string, double>> generators = {
+            {"random", 0.5}, {"random", 1.0}, {"ring", 1.0}, {"pump", 1.0}};
+
+    pattern_library_t library;
+    patternlib_init(library);
+    dfa *pattern = library.mappings[0]->initial;
+    modify_options_t options = modify_default_options();
+    options.num_threads = num_threads;
+    modify_options_t batch_options = options;
+    batch_options.batch_size = BATCH_MAX_LANES;
+
+    bool first = true;
+    printf("{\"benchmarks\": [\n");
+    for (auto &generator : generators) {
+        for (int alphabet_size : alphabet_sizes) {
+            for (int size : sizes) {
+                bench_model_t m;
+                m.generator = generator.first;
+                m.model = bench_generate(generator.first, size, alphabet_size, generator.second, size);
+                int defined = 0;
+                for (int transition : m.model->transition_matrix) defined += transition >= 0;
+                m.density = (double) defined / m.model->transition_matrix.size();
+                dfa *partner = bench_generate(generator.first, BENCH_PARTNER_STATES, alphabet_size,
+                        generator.second, size + 1);
+                dfa *prop_dfa = bench_property(alphabet_size, size + 2);
+                int error_states[1] = {BENCH_PROPERTY_STATES - 1};
+                Property p(*prop_dfa, interps::NOP, error_states, 1);
+                long long iterations;
+                double ns;
+
+                int skip = 0;
+                ns = bench_time([&]() {
+                    delete m.model->DFA_find_pattern(*pattern, skip);
+                    skip = (skip + 1) % 16;
+                }, min_seconds, iterations);
+                bench_print(first, "find_pattern", m, iterations, ns, size);
+                first = false;
+
+                long long product_states = 0;
+                ns = bench_time([&]() {
+                    dfa product(*m.model, *partner);
+                    product_states = product.num_states;
+                }, min_seconds, iterations);
+                bench_print(first, "compose", m, iterations, ns, product_states);
+
+                check_workspace workspace;
+                ns = bench_time([&]() {
+                    p.property_check(*m.model, workspace);
+                }, min_seconds, iterations);
+                bench_print(first, "property_check", m, iterations, ns, size);
+
+                p.set_engine(check_engine::BITSET);
+                ns = bench_time([&]() {
+                    p.property_check(*m.model, workspace);
+                }, min_seconds, iterations);
+                bench_print(first, "property_check_bitset", m, iterations, ns, size);
+                p.set_engine(check_engine::BFS);
+
+                /* Several properties over the same composition, one search each or one
+                 * search for all; states are those of the composition */
+                std::vector<dfa*> set_dfas;
+                std::vector<Property> set_properties;
+                PropertySet set;
+                for (int i = 0; i < BENCH_SET_PROPERTIES; i++) {
+                    set_dfas.push_back(bench_property(alphabet_size, size + 3 + i));
+                    set_properties.emplace_back(*set_dfas.back(), interps::NOP, error_states, 1);
+                }
+                for (Property &q : set_properties) set.add(q);
+                ns = bench_time([&]() {
+                    for (Property &q : set_properties) q.property_check(*m.model, *partner, workspace);
+                }, min_seconds, iterations);
+                bench_print(first, "property_check_each", m, iterations, ns, product_states);
+                ns = bench_time([&]() {
+                    set.check(*m.model, *partner);
+                }, min_seconds, iterations);
+                bench_print(first, "property_set", m, iterations, ns, product_states);
+                for (dfa *set_dfa : set_dfas) delete set_dfa;
+
+                /* The campaign reports on standard out, which is kept for the JSON */
+                std::streambuf *saved = std::cout.rdbuf(nullptr);
+                ns = bench_time([&]() {
+                    modify_violate_property(*m.model, *partner, &p, &library.mappings,
+                            BENCH_CAMPAIGN_TRIALS, options);
+                }, min_seconds, iterations);
+                std::cout.rdbuf(saved);
+                std::cout.clear();
+                bench_print(first, "campaign", m, iterations, ns, size);
+
+                saved = std::cout.rdbuf(nullptr);
+                ns = bench_time([&]() {
+                    modify_violate_property(*m.model, *partner, &p, &library.mappings,
+                            BENCH_CAMPAIGN_TRIALS, batch_options);
+                }, min_seconds, iterations);
+                std::cout.rdbuf(saved);
+                std::cout.clear();
+                bench_print(first, "campaign_batch", m, iterations, ns, size);
+
+                delete m.model;
+                delete partner;
+                delete prop_dfa;
+            }
+        }
+    }
+    printf("\n], \"peak_rss_kb\": %ld}\n", bench_peak_rss_kb());
+    return 0;
+}
+
+static dfa *bench_generate(const std::string &generator, int size, int alphabet_size,
+        double density, unsigned seed) {
+    if (generator == "ring") {
+        return ex_ring(size, alphabet_size);
+    } else if (generator == "pump") {
+        return ex_pump(size, alphabet_size);
+    }
+    return ex_random(size, alphabet_size, density, seed);
+}
+
+static dfa *bench_property(int alphabet_size, unsigned seed) {
+    /* A random DFA over the safe states, with the error state appended */
+    dfa *safe = ex_random(BENCH_PROPERTY_STATES - 1, alphabet_size, 0.5, seed);
+    std::vector<int> transitions = safe->transition_matrix;
+    transitions.resize(BENCH_PROPERTY_STATES * alphabet_size, DFA_DUMMY_SYMBOL);
+    std::vector<bool> finals(BENCH_PROPERTY_STATES, false);
+    dfa *prop_dfa = new dfa(BENCH_PROPERTY_STATES, 0, finals, safe->alphabet, transitions.data());
+    delete safe;
+    return prop_dfa;
+}
+
+static double bench_time(const std::function<void()> &op, double min_seconds, long long &iterations) {
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    iterations = 0;
+    while (iterations == 0 || elapsed < min_seconds) {
+        op();
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return elapsed * 1e9 / iterations;
+}
+
+static long bench_peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void bench_print(bool first, const char *name, const bench_model_t &m,
+        long long iterations, double ns_per_op, long long states) {
+    printf("%s  {\"name\": \"%s\", \"generator\": \"%s\", \"states\": %d, \"alphabet\": %d, "
+           "\"density\": %.3f, \"iterations\": %lld, \"ns_per_op\": %.1f, "
+           "\"states_per_sec\": %.1f, \"peak_rss_kb\": %ld}",
+           first ? "" : ",\n", name, m.generator.c_str(), m.model->num_states,
+           m.model->alphabet_size, m.density, iterations, ns_per_op,
+           states * 1e9 / ns_per_op, bench_peak_rss_kb());
+}
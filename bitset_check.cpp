@@ -0,0 +1,145 @@
+/** @file bitset_check.cpp
+ *  @brief Bit-parallel property checking engine
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include "inc/bitset_check.h"
+
+/* *****     IMPLEMENTATION     ***** */
+
+bitset_checker::bitset_checker(const dfa& right, const std::vector<bool>& error, bool undefined_stays,
+        const std::vector<bool> *live) {
+    int alphabet_size = right.alphabet_size;
+    this->num_states = right.num_states;
+    this->initial_state = right.initial_state;
+    this->num_words = (this->num_states + 63) / 64;
+    this->error_mask.assign(this->num_words, 0);
+    this->live_mask.assign(this->num_words, 0);
+    this->stay_masks.assign((size_t) alphabet_size * this->num_words, 0);
+    this->move_masks.assign((size_t) alphabet_size * this->num_words, 0);
+    this->targets.assign((size_t) alphabet_size * this->num_states, DFA_DUMMY_SYMBOL);
+
+    for (int s = 0; s < this->num_states; s++) {
+        uint64_t bit = 1ULL << (s & 63);
+        int word = s >> 6;
+        if (error[s]) this->error_mask[word] |= bit;
+        if (live == nullptr || (*live)[s]) this->live_mask[word] |= bit;
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            int target = right.apply(s, symb_ind);
+            if (target < 0 && undefined_stays) target = s;
+            if (target == s) {
+                this->stay_masks[(size_t) symb_ind * this->num_words + word] |= bit;
+            } else if (target >= 0) {
+                this->move_masks[(size_t) symb_ind * this->num_words + word] |= bit;
+                this->targets[(size_t) symb_ind * this->num_states + s] = target;
+            }
+        }
+    }
+}
+
+bool bitset_checker::check(const dfa& left, const std::vector<int>& left_symbols,
+        const std::vector<int>& right_symbols, check_workspace& workspace) const {
+    int num_words = this->num_words;
+    int num_symbols = left_symbols.size();
+    size_t rows_size = (size_t) left.num_states * num_words;
+
+    /* Only the temporary arrays of the workspace are used, so its visited set is
+     * left empty */
+    workspace.reset(0);
+
+    /* Visited, current frontier and next frontier rows, followed by one scratch row.
+     * The storage is only cleared where the last check marked it, so every row this
+     * check may set is marked: the scratch row now, and the three rows of a left
+     * state when it is first reached */
+    uint64_t *visited = workspace.bitsets(3 * rows_size + num_words);
+    uint64_t *frontier = visited + rows_size;
+    uint64_t *next = frontier + rows_size;
+    uint64_t *image = next + rows_size;
+    workspace.bitsets_mark(3 * rows_size, num_words);
+
+    /* Left states whose frontier row is not empty; a state is in next_active at most
+     * once, so each list holds at most every left state */
+    int *active = workspace.allocate<int>(left.num_states);
+    int *next_active = workspace.allocate<int>(left.num_states);
+    int num_active = 0;
+    int num_next = 0;
+    char *in_next = workspace.allocate<char>(left.num_states);
+    char *reached = workspace.allocate<char>(left.num_states);
+    std::fill_n(in_next, left.num_states, 0);
+    std::fill_n(reached, left.num_states, 0);
+
+    active[num_active++] = left.initial_state;
+    reached[left.initial_state] = 1;
+    for (int region = 0; region < 3; region++) {
+        workspace.bitsets_mark(region * rows_size + (size_t) left.initial_state * num_words, num_words);
+    }
+    size_t first = (size_t) left.initial_state * num_words + (this->initial_state >> 6);
+    visited[first] |= 1ULL << (this->initial_state & 63);
+    frontier[first] |= 1ULL << (this->initial_state & 63);
+
+    while (num_active > 0) {
+        num_next = 0;
+        for (int i = 0; i < num_active; i++) {
+            int a = active[i];
+            uint64_t *row = frontier + (size_t) a * num_words;
+            for (int k = 0; k < num_symbols; k++) {
+                int a_target = left_symbols[k] < 0 ? a : left.apply(a, left_symbols[k]);
+                if (a_target == DFA_DUMMY_SYMBOL) {
+                    continue;
+                }
+
+                /* Successors of the whole row on this symbol */
+                const uint64_t *successors = row;
+                int r = right_symbols[k];
+                if (r >= 0) {
+                    const uint64_t *stay = &this->stay_masks[(size_t) r * num_words];
+                    const uint64_t *move = &this->move_masks[(size_t) r * num_words];
+                    const int *target = &this->targets[(size_t) r * this->num_states];
+                    for (int w = 0; w < num_words; w++) image[w] = row[w] & stay[w];
+                    for (int w = 0; w < num_words; w++) {
+                        for (uint64_t bits = row[w] & move[w]; bits != 0; bits &= bits - 1) {
+                            int t = target[w * 64 + __builtin_ctzll(bits)];
+                            image[t >> 6] |= 1ULL << (t & 63);
+                        }
+                    }
+                    successors = image;
+                }
+
+                bool fresh = false;
+                uint64_t *visited_row = visited + (size_t) a_target * num_words;
+                uint64_t *next_row = next + (size_t) a_target * num_words;
+                for (int w = 0; w < num_words; w++) {
+                    if (successors[w] & this->error_mask[w]) {
+                        return false;
+                    }
+                    uint64_t added = successors[w] & this->live_mask[w] & ~visited_row[w];
+                    if (added) {
+                        visited_row[w] |= added;
+                        next_row[w] |= added;
+                        fresh = true;
+                    }
+                }
+                if (fresh && !in_next[a_target]) {
+                    in_next[a_target] = 1;
+                    next_active[num_next++] = a_target;
+                    if (!reached[a_target]) {
+                        reached[a_target] = 1;
+                        for (int region = 0; region < 3; region++) {
+                            workspace.bitsets_mark(region * rows_size +
+                                    (size_t) a_target * num_words, num_words);
+                        }
+                    }
+                }
+            }
+            for (int w = 0; w < num_words; w++) row[w] = 0;
+        }
+        std::swap(frontier, next);
+        std::swap(active, next_active);
+        num_active = num_next;
+        for (int i = 0; i < num_active; i++) in_next[active[i]] = 0;
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+/** @file check_workspace.cpp
+ *  @brief Reusable state storage of property checks
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include "inc/check_workspace.h"
+
+#define INITIAL_TABLE_SIZE  (1 << 10)
+#define INITIAL_RING_SIZE   (1 << 10)
+
+/* *****     IMPLEMENTATION     ***** */
+
+check_workspace::check_workspace() {
+    this->dense = true;
+    this->ring.resize(INITIAL_RING_SIZE);
+    this->head = 0;
+    this->tail = 0;
+    this->tracing = false;
+}
+
+void check_workspace::reset(uint64_t key_space, bool tracing) {
+    this->head = 0;
+    this->tail = 0;
+    this->tracing = tracing;
+    this->trace_keys.clear();
+    this->trace_parents.clear();
+    this->trace_symbols.clear();
+    this->temporary.reset();
+
+    /* Only what the last search set is cleared; the rest is already zero */
+    for (uint64_t word : this->bitmap_words) this->bitmap[word] = 0;
+    this->bitmap_words.clear();
+    for (uint64_t pos : this->table_slots) this->table[pos] = 0;
+    this->table_slots.clear();
+
+    this->dense = key_space <= WORKSPACE_MAX_BITMAP_KEYS;
+    if (this->dense) {
+        uint64_t words = (key_space + 63) / 64;
+        if (this->bitmap.size() < words) this->bitmap.resize(words, 0);
+    } else if (this->table.empty()) {
+        this->table.resize(INITIAL_TABLE_SIZE);
+    }
+}
+
+bool check_workspace::table_insert(uint64_t key) {
+    uint64_t mask = this->table.size() - 1;
+    for (uint64_t pos = workspace_hash(key) & mask;; pos = (pos + 1) & mask) {
+        if (this->table[pos] == key + 1) return false;
+        if (this->table[pos] == 0) {
+            this->table[pos] = key + 1;
+            this->table_slots.push_back(pos);
+            /* Keep the load factor at or below one half */
+            if (this->table_slots.size() * 2 > this->table.size()) this->grow_table();
+            return true;
+        }
+    }
+}
+
+void check_workspace::grow_table() {
+    std::vector<uint64_t> old_table(this->table.size() * 2, 0);
+    old_table.swap(this->table);
+    uint64_t mask = this->table.size() - 1;
+    for (uint64_t &old_pos : this->table_slots) {
+        uint64_t slot = old_table[old_pos];
+        uint64_t pos = workspace_hash(slot - 1) & mask;
+        while (this->table[pos] != 0) pos = (pos + 1) & mask;
+        this->table[pos] = slot;
+        old_pos = pos;
+    }
+}
+
+void check_workspace::grow_ring() {
+    /* Keys keep their positions, which the trace log refers to, so only the slot
+     * each one maps to changes */
+    std::vector<uint64_t> new_ring(this->ring.size() * 2);
+    uint64_t old_mask = this->ring.size() - 1;
+    uint64_t new_mask = new_ring.size() - 1;
+    for (uint64_t pos = this->head; pos != this->tail; pos++) {
+        new_ring[pos & new_mask] = this->ring[pos & old_mask];
+    }
+    this->ring.swap(new_ring);
+}
+
+void check_workspace::trace_back(std::vector<uint64_t> &keys, std::vector<int> &symbols) const {
+    keys.clear();
+    symbols.clear();
+    for (int64_t pos = (int64_t) this->head - 1; pos >= 0; pos = this->trace_parents[pos]) {
+        keys.push_back(this->trace_keys[pos]);
+        if (this->trace_parents[pos] >= 0) symbols.push_back(this->trace_symbols[pos]);
+    }
+    std::reverse(keys.begin(), keys.end());
+    std::reverse(symbols.begin(), symbols.end());
+}
+
+uint64_t *check_workspace::bitsets(size_t words) {
+    /* Only what the last search marked is cleared; the rest is already zero */
+    for (auto &range : this->bits_marked) {
+        std::fill_n(this->bits.begin() + range.first, range.second, 0);
+    }
+    this->bits_marked.clear();
+    if (this->bits.size() < words) this->bits.resize(words, 0);
+    return this->bits.data();
+}
@@ -0,0 +1,48 @@
+/** @file convert.cpp
+ *  @brief Converts LTSA output to the binary DFA file format
+ *  @author Brian Wei
+ *
+ *  Usage: Verif_convert <LTSA output> <binary DFA file> [error state ...]
+ *
+ *  Error states are only needed when the model is a property.  The written
+ *  file is mapped back and validated in place (see dfa_view) before returning.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#include "inc/dfa_file.h"
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <LTSA output> <binary DFA file> [error state ...]\n", argv[0]);
+        return 1;
+    }
+    std::set<int> error_states;
+    for (int i = 3; i < argc; i++) {
+        error_states.insert(atoi(argv[i]));
+    }
+
+    int err = dfafile_convert(argv[1], argv[2], error_states);
+    if (err == DFAFILE_BAD_FORMAT) {
+        fprintf(stderr, "Could not convert %s\n", argv[1]);
+        return 1;
+    } else if (err != DFAFILE_NO_ERROR) {
+        fprintf(stderr, "Could not write %s\n", argv[2]);
+        return 1;
+    }
+
+    dfa_view view;
+    if (view.open(argv[2]) != DFAFILE_NO_ERROR) {
+        fprintf(stderr, "Written file %s does not read back as a valid DFA\n", argv[2]);
+        return 1;
+    }
+    int num_errors = 0;
+    for (int s = 0; s < view.num_states(); s++) {
+        if (view.is_error(s)) num_errors++;
+    }
+    printf("%s: %d states, %d symbols, %d error states\n", argv[2], view.num_states(),
+           view.alphabet_size(), num_errors);
+    return 0;
+}
@@ -0,0 +1,226 @@
+/** @file dfa_file.cpp
+ *  @brief Binary DFA file format
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "inc/dfa_file.h"
+#include "inc/ltsa_parser.h"
+
+/** @brief Rounds a file offset up to the next section boundary
+ *
+ * @param offset Offset to round
+ * @return Smallest multiple of 8 no less than offset
+ */
+static inline uint64_t align_section(uint64_t offset);
+
+/** @brief Returns whether a section lies within a file and starts on a boundary
+ *
+ * @param offset Offset of the section
+ * @param size Size of the section, in bytes
+ * @param file_size Size of the file, in bytes
+ * @return True if the section is valid
+ */
+static bool section_valid(uint64_t offset, uint64_t size, uint64_t file_size);
+
+/* *****     IMPLEMENTATION     ***** */
+
+dfa_view::dfa_view() {
+    this->mapping = nullptr;
+    this->mapping_size = 0;
+    this->header = nullptr;
+}
+
+dfa_view::~dfa_view() {
+    this->close();
+}
+
+void dfa_view::close() {
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->mapping_size);
+        this->mapping = nullptr;
+        this->mapping_size = 0;
+        this->header = nullptr;
+    }
+}
+
+int dfa_view::open(const char *path) {
+    this->close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return DFAFILE_IO_ERROR;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return DFAFILE_IO_ERROR;
+    }
+    if (info.st_size < (off_t) sizeof(dfafile_header_t)) {
+        ::close(fd);
+        return DFAFILE_BAD_FORMAT;
+    }
+    void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return DFAFILE_IO_ERROR;
+    }
+    this->mapping = mapping;
+    this->mapping_size = info.st_size;
+
+    const char *base = (const char *) mapping;
+    const dfafile_header_t *h = (const dfafile_header_t *) base;
+    int err = DFAFILE_NO_ERROR;
+    if (memcmp(h->magic, DFAFILE_MAGIC, sizeof(h->magic)) != 0 || h->byte_order != DFAFILE_BYTE_ORDER) {
+        err = DFAFILE_BAD_FORMAT;
+    } else if (h->version != DFAFILE_VERSION) {
+        err = DFAFILE_BAD_VERSION;
+    } else if (h->file_size != this->mapping_size || h->num_states <= 0 || h->alphabet_size < 0 ||
+            h->initial_state < 0 || h->initial_state >= h->num_states) {
+        err = DFAFILE_BAD_FORMAT;
+    } else {
+        uint64_t num_states = h->num_states;
+        uint64_t bitmap_size = (num_states + 63) / 64 * sizeof(uint64_t);
+        if (!section_valid(h->alphabet_offset, h->alphabet_size * sizeof(uint32_t) + h->names_size,
+                    h->file_size) ||
+                !section_valid(h->table_offset, num_states * h->alphabet_size * sizeof(int32_t),
+                    h->file_size) ||
+                !section_valid(h->finals_offset, bitmap_size, h->file_size) ||
+                !section_valid(h->errors_offset, bitmap_size, h->file_size)) {
+            err = DFAFILE_BAD_FORMAT;
+        }
+    }
+    if (err != DFAFILE_NO_ERROR) {
+        this->close();
+        return err;
+    }
+
+    this->header = h;
+    this->name_offsets = (const uint32_t *) (base + h->alphabet_offset);
+    this->names = (const char *) (this->name_offsets + h->alphabet_size);
+    this->table = (const int32_t *) (base + h->table_offset);
+    this->finals = (const uint64_t *) (base + h->finals_offset);
+    this->errors = (const uint64_t *) (base + h->errors_offset);
+
+    /* Every name must be terminated within the name block, and every transition
+     * must lead to a state, so that no access through the view can go astray */
+    if (h->alphabet_size > 0 && (h->names_size == 0 || this->names[h->names_size - 1] != '\0')) {
+        err = DFAFILE_BAD_FORMAT;
+    }
+    for (int i = 0; i < h->alphabet_size && err == DFAFILE_NO_ERROR; i++) {
+        if (this->name_offsets[i] >= h->names_size) err = DFAFILE_BAD_FORMAT;
+    }
+    uint64_t table_size = (uint64_t) h->num_states * h->alphabet_size;
+    for (uint64_t i = 0; i < table_size && err == DFAFILE_NO_ERROR; i++) {
+        if (this->table[i] < DFA_DUMMY_SYMBOL || this->table[i] >= h->num_states) err = DFAFILE_BAD_FORMAT;
+    }
+    if (err != DFAFILE_NO_ERROR) {
+        this->close();
+    }
+    return err;
+}
+
+dfa *dfa_view::to_dfa(std::set<int> *error_states) const {
+    int num_states = this->num_states();
+    std::vector<bool> finals(num_states, false);
+    for (int s = 0; s < num_states; s++) {
+        finals[s] = this->is_final(s);
+        if (error_states != nullptr && this->is_error(s)) error_states->insert(s);
+    }
+    std::vector<std::string> symbols;
+    for (int i = 0; i < this->alphabet_size(); i++) {
+        symbols.emplace_back(this->symbol_name(i));
+    }
+    return new dfa(num_states, this->alphabet_size(), this->initial_state(),
+            finals, symbols, this->table);
+}
+
+int dfafile_write(const char *path, const dfa &M, const std::set<int> &error_states) {
+    dfafile_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DFAFILE_MAGIC, sizeof(header.magic));
+    header.version = DFAFILE_VERSION;
+    header.byte_order = DFAFILE_BYTE_ORDER;
+    header.num_states = M.num_states;
+    header.alphabet_size = M.alphabet_size;
+    header.initial_state = M.initial_state;
+
+    std::vector<uint32_t> name_offsets;
+    std::string names;
+    for (int i = 0; i < M.alphabet_size; i++) {
+        name_offsets.push_back(names.size());
+        names += M.get_symbol_name(i);
+        names.push_back('\0');
+    }
+    header.names_size = names.size();
+
+    uint64_t bitmap_words = ((uint64_t) M.num_states + 63) / 64;
+    std::vector<uint64_t> finals(bitmap_words, 0), errors(bitmap_words, 0);
+    for (int s : M.final_states) finals[s >> 6] |= 1ULL << (s & 63);
+    for (int s : error_states) {
+        if (s >= 0 && s < M.num_states) errors[s >> 6] |= 1ULL << (s & 63);
+    }
+
+    header.alphabet_offset = align_section(sizeof(header));
+    header.table_offset = align_section(header.alphabet_offset +
+            name_offsets.size() * sizeof(uint32_t) + names.size());
+    header.finals_offset = align_section(header.table_offset +
+            M.transition_matrix.size() * sizeof(int32_t));
+    header.errors_offset = header.finals_offset + bitmap_words * sizeof(uint64_t);
+    header.file_size = header.errors_offset + bitmap_words * sizeof(uint64_t);
+
+    /* Sections are written in order, padded with zeros up to their offsets */
+    FILE *f = fopen(path, "wb");
+    if (f == nullptr) {
+        return DFAFILE_IO_ERROR;
+    }
+    static const char padding[8] = {0};
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && fwrite(name_offsets.data(), sizeof(uint32_t), name_offsets.size(), f) == name_offsets.size();
+    ok = ok && fwrite(names.data(), 1, names.size(), f) == names.size();
+    uint64_t written = header.alphabet_offset + name_offsets.size() * sizeof(uint32_t) + names.size();
+    ok = ok && fwrite(padding, 1, header.table_offset - written, f) == header.table_offset - written;
+    ok = ok && fwrite(M.transition_matrix.data(), sizeof(int32_t), M.transition_matrix.size(), f) ==
+            M.transition_matrix.size();
+    written = header.table_offset + M.transition_matrix.size() * sizeof(int32_t);
+    ok = ok && fwrite(padding, 1, header.finals_offset - written, f) == header.finals_offset - written;
+    ok = ok && fwrite(finals.data(), sizeof(uint64_t), bitmap_words, f) == bitmap_words;
+    ok = ok && fwrite(errors.data(), sizeof(uint64_t), bitmap_words, f) == bitmap_words;
+    ok = (fclose(f) == 0) && ok;
+    return ok ? DFAFILE_NO_ERROR : DFAFILE_IO_ERROR;
+}
+
+dfa *dfafile_load(const char *path, std::set<int> *error_states) {
+    dfa_view view;
+    if (view.open(path) != DFAFILE_NO_ERROR) {
+        return nullptr;
+    }
+    return view.to_dfa(error_states);
+}
+
+int dfafile_convert(const char *ltsa_path, const char *path, const std::set<int> &error_states) {
+    dfa *M = parser_go(ltsa_path);
+    if (M == nullptr) {
+        return DFAFILE_BAD_FORMAT;
+    }
+    int err = dfafile_write(path, *M, error_states);
+    delete M;
+    return err;
+}
+
+static inline uint64_t align_section(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t) 7;
+}
+
+static bool section_valid(uint64_t offset, uint64_t size, uint64_t file_size) {
+    return offset % 8 == 0 && offset >= sizeof(dfafile_header_t) &&
+            offset <= file_size && size <= file_size - offset;
+}
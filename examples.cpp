@@ -5,24 +5,86 @@
  *  Detailed documentation may be found in the header file examples.h
  */
 
+#include <cassert>
+#include <random>
 #include "inc/examples.h"
 #include "inc/ltsa_parser.h"
 
+/** @brief Names the symbols of a generated DFA
+ *
+ * @param alphabet_size Number of symbols
+ * @return Symbol names S0, S1, ...
+ */
+static std::vector<std::string> ex_symbol_names(int alphabet_size);
+
 dfa *ex_cycle(int size) {
     assert(size > 0);
     auto *symbols = new std::vector<std::string>({"A", "B"});
 
     std::vector<bool> main_finals(size, false);
     std::vector<int> transitions;
-    transitions.resize(size * 2);
+    transitions.resize((size_t) size * 2);
     for (int i = 0; i < size; i++) {
-        transitions[i * 2] = (i + 1) % size;
-        transitions[i * 2 + 1] = (i - 1) % size;
+        transitions[(size_t) i * 2] = (i + 1) % size;
+        transitions[(size_t) i * 2 + 1] = (i - 1) % size;
     }
     return new dfa(size, 2, 0,
             main_finals, *symbols, transitions.data());
 }
 
+dfa *ex_random(int size, int alphabet_size, double density, unsigned seed) {
+    assert(size > 0 && alphabet_size > 0);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::uniform_int_distribution<int> target(0, size - 1);
+
+    std::vector<bool> finals(size, false);
+    std::vector<int> transitions((size_t) size * alphabet_size);
+    for (int &transition : transitions) {
+        transition = coin(rng) < density ? target(rng) : DFA_DUMMY_SYMBOL;
+    }
+    return new dfa(size, alphabet_size, 0,
+            finals, ex_symbol_names(alphabet_size), transitions.data());
+}
+
+dfa *ex_ring(int size, int alphabet_size) {
+    assert(size > 0 && alphabet_size > 0);
+    std::vector<bool> finals(size, false);
+    std::vector<int> transitions((size_t) size * alphabet_size);
+    for (int i = 0; i < size; i++) {
+        for (int k = 0; k < alphabet_size; k++) {
+            transitions[(size_t) i * alphabet_size + k] = (i + k + 1) % size;
+        }
+    }
+    return new dfa(size, alphabet_size, 0,
+            finals, ex_symbol_names(alphabet_size), transitions.data());
+}
+
+dfa *ex_pump(int size, int alphabet_size) {
+    assert(size >= 3 && alphabet_size >= 2);
+    int loop_start = (size - 1) / 4;
+    int loop_size = size - 1 - loop_start;
+    int sink = size - 1;
+
+    std::vector<bool> finals(size, false);
+    finals[sink] = true;
+    std::vector<int> transitions((size_t) size * alphabet_size, DFA_DUMMY_SYMBOL);
+    for (int i = 0; i < loop_start; i++) {
+        transitions[(size_t) i * alphabet_size] = i + 1;
+    }
+    for (int i = loop_start; i < sink; i++) {
+        int pos = i - loop_start;
+        transitions[(size_t) i * alphabet_size] = sink;
+        transitions[(size_t) i * alphabet_size + 1] = loop_start + (pos + 1) % loop_size;
+        for (int k = 2; k < alphabet_size; k++) {
+            transitions[(size_t) i * alphabet_size + k] = loop_start +
+                    ((pos - (k - 1)) % loop_size + loop_size) % loop_size;
+        }
+    }
+    return new dfa(size, alphabet_size, 0,
+            finals, ex_symbol_names(alphabet_size), transitions.data());
+}
+
 dfa *ex_cdm() {
     std::vector<bool> finals(6, false);
     auto *transitions = new int[12] {1,1,2,3,4,5,5,4,5,5,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
@@ -95,4 +157,12 @@ dfa *ex_human() {
 
 dfa *ex_prop() {
     return parser_go("./ltsa_models/infusion_pump_amtchecker");
-}
\ No newline at end of file
+}
+
+static std::vector<std::string> ex_symbol_names(int alphabet_size) {
+    std::vector<std::string> names;
+    for (int k = 0; k < alphabet_size; k++) {
+        names.push_back("S" + std::to_string(k));
+    }
+    return names;
+}
@@ -2,17 +2,19 @@
  *  @brief Header for DFA structure
  *  @author Brian Wei
  *
- *  We implement the structure for a DFA with the transition matrix stored as an
- *  array which maps origin state and symbol (as indexes) to the destination state.
- *  This allowed efficient access into the array, which is a highly used operation
- *  within the algorithms that are implemented here.
- *  The DFA_find_pattern function is a brute force algorithm that iterates over
- *  all permutations of states in the DFA to see if there are any suitable in being
- *  a match to the pattern state machine.
+ *  We implement the structure for a DFA with the transition matrix stored as a
+ *  single flat row-major array which maps origin state and symbol (as indexes) to
+ *  the destination state.  This allows efficient access into the array, which is a
+ *  highly used operation within the algorithms that are implemented here; hot
+ *  loops should use apply() with symbol indexes rather than the string interface.
+ *  The DFA_find_pattern function searches for instances of a pattern state
+ *  machine using the pruned backtracking search in pattern_match.h.
  */
 #ifndef __VERIF_DFA_H__
 #define __VERIF_DFA_H__
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <set>
@@ -30,11 +32,47 @@
 class pattern_output {
 public:
     std::vector<int> states;    /* States in the DFA */
-    std::vector<std::string> symbols;  /* Symbols of the DFA */
+    std::vector<int> symbols;   /* Symbols of the DFA, as interned symbol IDs */
 };
 
 
-/* Structure for a DFA; transition matrix is structured as:
+/* 128-bit structural digest of a DFA, see DFA_digest() */
+typedef struct dfa_digest {
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(const dfa_digest& other) const {
+        return this->low == other.low && this->high == other.high;
+    }
+} dfa_digest_t;
+
+/* Alphabet of a DFA, stored as interned symbol IDs (see symbol_table.h).  It is
+ * immutable once built so that a DFA and all of its clones can share it. */
+class dfa_alphabet {
+public:
+    std::vector<int> symbols;   /* Symbol ID of each alphabet index */
+    std::vector<int> lookup;    /* Alphabet index of each symbol ID, or
+                * DFA_INVALID_SYMBOL; only covers IDs up to the largest in symbols */
+
+    /** @brief Constructs an alphabet from interned symbol IDs
+     *
+     * @param symbols Symbol IDs in alphabet order, must not contain duplicates
+     */
+    explicit dfa_alphabet(const std::vector<int>& symbols);
+
+    /** @brief Returns the index of a symbol ID in this alphabet
+     *
+     * @param symbol_id Interned ID of the symbol
+     * @return Index of the symbol or DFA_INVALID_SYMBOL if not in the alphabet
+     */
+    int index_of(int symbol_id) const {
+        return symbol_id >= 0 && symbol_id < (int) this->lookup.size() ?
+            this->lookup[symbol_id] : DFA_INVALID_SYMBOL;
+    }
+};
+
+
+/* Structure for a DFA; transition matrix is conceptually structured as:
 *                  symbol
 * Starting state   42   99
 *             0    0    -1
@@ -47,17 +85,42 @@ class dfa {
 private:
 
 
-    void DFA_constructor_helper(int num_states, int alphabet_size, int initial_state,
-            std::vector<bool>& finals, const std::vector<std::string>& symbols,
+    void DFA_constructor_helper(int num_states, int initial_state,
+            std::vector<bool>& finals, std::shared_ptr<const dfa_alphabet> alphabet,
             const int *transition_matrix);
+
+    /* Builds the full product of two DFAs, see dfa(dfa&, dfa&) */
+    void DFA_full_composition_helper(dfa& dfa_1, dfa& dfa_2);
+
+    /* Builds the reachable part of the product of two DFAs, see dfa(dfa&, dfa&, bool) */
+    void DFA_reachable_composition_helper(dfa& dfa_1, dfa& dfa_2);
+
+    /* Partitions the given states into classes of equivalent states, that is states
+     * with the same finality whose transitions on every symbol are both undefined or
+     * lead to equivalent states; the states must be closed under transitions.
+     * Stores the class of each given state in classes, -1 for all others, and
+     * returns the number of classes.  Uses Hopcroft's algorithm, in
+     * O(n * |alphabet| * log n) time for n states */
+    int DFA_equivalence_helper(const std::vector<int>& states, std::vector<int>& classes) const;
+
+    /* Builds the transitions and final states of the canonical form, see DFA_canonical(),
+     * and returns its number of states; if mapping is given, stores the canonical state
+     * of every state in it, -1 for unreachable states */
+    int DFA_canonical_helper(std::vector<int>& transitions, std::vector<bool>& finals,
+            std::vector<int> *mapping) const;
 public:
     int num_states;         /* Number of states */
     int initial_state;      /* Initial state    */
+    int alphabet_size;      /* Number of symbols in the alphabet */
     std::set<int> final_states; /* Accepting states */
-    std::vector<std::string> alphabet_symbols;  /* Symbols in the alphabet */
-    std::vector<std::vector<int>> transition_matrix; /* Transition matrix of
-                * num_states * alphabet_size where tm[i][j] is the destination
-                * from state i on transition alphabet_symbols[j] */
+    std::shared_ptr<const dfa_alphabet> alphabet;  /* Symbols in the alphabet,
+                * shared with clones */
+    std::vector<int> transition_matrix; /* Flat row-major transition matrix of
+                * num_states * alphabet_size where tm[i * alphabet_size + j] is the
+                * destination from state i on transition alphabet->symbols[j] */
+    std::vector<std::pair<int, int>> component_states; /* For reachable-only
+                * compositions, the (dfa_1, dfa_2) states each state stands for;
+                * empty for every other DFA */
 
     /** @brief Constructs a new DFA
      *
@@ -70,6 +133,17 @@ public:
         std::vector<bool>& finals, const std::vector<std::string>& symbols,
         const int *transition_matrix);
 
+    /** @brief Constructs a new DFA over an already interned alphabet
+     *
+     * @param num_states Number of states in the DFA
+     * @param initial_state Initial state
+     * @param finals List of final states
+     * @param alphabet Alphabet of the DFA, may be shared with other DFAs
+     * @param transition_matrix Transition matrix
+     */
+    dfa(int num_states, int initial_state, std::vector<bool>& finals,
+        std::shared_ptr<const dfa_alphabet> alphabet, const int *transition_matrix);
+
     /** @brief Takes the parallel composition of two dfa's
      *
      * @param dfa_1 First input DFA
@@ -77,19 +151,60 @@ public:
      */
     dfa(dfa& dfa_1, dfa& dfa_2);
 
+    /** @brief Takes the parallel composition of two dfa's, optionally reachable-only
+     *
+     * With reachable_only set, the product is expanded from the pair of initial states
+     * and only reachable pairs become states.  They are numbered compactly in
+     * breadth-first order starting from 0 for the initial pair, and component_states
+     * records which pair each state stands for.  Otherwise this is identical to
+     * dfa(dfa_1, dfa_2), where pair (s1, s2) is state s1 * dfa_2.num_states + s2.
+     *
+     * @param dfa_1 First input DFA
+     * @param dfa_2 Second input DFA
+     * @param reachable_only Whether to only build reachable state pairs
+     */
+    dfa(dfa& dfa_1, dfa& dfa_2, bool reachable_only);
+
     /** @brief Constructs a clone of a DFA
      *
      * @param source DFA to clone
      */
-    dfa(dfa& source);
+    dfa(const dfa& source);
 
     /** @brief Returns the index of a given symbol based on the DFA's alphabet
      *
      * @param symbol Symbol to look for
-     * @return Index in the alphabet_symbols array of the symbol or a negative error code if not found
+     * @return Index in the alphabet of the symbol or a negative error code if not found
      */
     int get_symbol_index(const std::string& symbol);
 
+    /** @brief Returns the index of a given interned symbol based on the DFA's alphabet
+     *
+     * @param symbol_id Interned ID of the symbol to look for
+     * @return Index in the alphabet of the symbol or a negative error code if not found
+     */
+    int get_symbol_index(int symbol_id) const {
+        return this->alphabet->index_of(symbol_id);
+    }
+
+    /** @brief Returns the name of the symbol at an index of the DFA's alphabet
+     *
+     * @param symbol_index Index in the alphabet, must be valid
+     * @return Name of the symbol
+     */
+    const std::string& get_symbol_name(int symbol_index) const;
+
+    /** @brief Aligns this DFA's alphabet against the alphabet of another DFA
+     *
+     * Intended to be computed once before a loop over symbols, so that the loop itself
+     * can translate symbol indexes between the two DFAs by a single array access.
+     *
+     * @param other DFA to align against
+     * @return Vector with, for each symbol index of this DFA, the index of the same
+     *      symbol in other or DFA_INVALID_SYMBOL if other does not have it
+     */
+    std::vector<int> DFA_align_alphabet(const dfa& other) const;
+
     /** @brief Runs a trace through a DFA
      *
      * @param trace Input trace, integer array of symbols
@@ -99,13 +214,13 @@ public:
 
     /** @brief Finds a pattern DFA withing a given DFA
      *
-     * A brute force approach which considers all permutations of states in the DFA and checks
-     * that there is some set of symbols for which the transitions will match in the two state
-     * machines.
+     * Uses a pattern_matcher, so instances are considered in lexicographic order of their
+     * states and then of their symbols, and the first skip_counter of them are skipped.
      *
-     * @note Returned pointer is generated by a malloc call and thus should be freed after use
+     * @note Returned pointer is generated by new and thus should be deleted after use
      *
      * @param pattern DFA representing the pattern we want
+     * @param skip_counter Number of instances to skip
      * @return an array indicating the states and symbols which match the pattern,
      *      or NULL is it cannot be found
      */
@@ -119,10 +234,80 @@ public:
      *
      * @param original_pattern
      * @param target_pattern
+     * @param skips Number of instances of original_pattern to skip
      * @return 0 on success, negative error code on failure
      */
     int DFA_modify(dfa& original_pattern, dfa& target_pattern, int skips);
 
+    /** @brief Modifies a known instance of a pattern into a target pattern
+     *
+     * Same as DFA_modify above, but for an instance that was already found, for
+     * example by a pattern_matcher, so no search is done.
+     *
+     * @param original_pattern Pattern which the instance is of
+     * @param target_pattern Pattern to replace the instance with
+     * @param pattern Instance of original_pattern in this DFA
+     * @return 0 on success, negative error code on failure
+     */
+    int DFA_modify(dfa& original_pattern, dfa& target_pattern, const pattern_output& pattern);
+
+    /** @brief Computes a hash of the structure of the DFA
+     *
+     * Covers the number of states, the initial state, the alphabet (as interned IDs, in
+     * order), the final states and the transition matrix, so DFAs for which DFA_equal
+     * holds hash the same.
+     *
+     * @return 64-bit structural hash
+     */
+    uint64_t DFA_hash() const;
+
+    /** @brief Compares the structure of two DFAs
+     *
+     * @param other DFA to compare with
+     * @return True if both have the same states, alphabet, finals and transitions
+     */
+    bool DFA_equal(const dfa& other) const;
+
+    /** @brief Computes a 128-bit digest of the structure of the DFA
+     *
+     * Covers the same fields as DFA_hash(), with two independent 64-bit lanes, so that
+     * digests can stand in for the DFAs themselves when deduplicating.
+     *
+     * @return 128-bit structural digest
+     */
+    dfa_digest_t DFA_digest() const;
+
+    /** @brief Builds the canonical form of the DFA
+     *
+     * The canonical form keeps only reachable states, merges equivalent states (see
+     * DFA_equivalence_helper) and numbers the result in breadth-first order from the
+     * initial state, following symbols in alphabet order.  Two DFAs over the same
+     * alphabet have equal canonical forms exactly when they accept the same traces
+     * with the same final states, so they satisfy the same properties.
+     *
+     * @return Pointer to the new canonical DFA, which shares this DFA's alphabet
+     */
+    dfa *DFA_canonical() const;
+
+    /** @brief Minimizes the DFA
+     *
+     * Builds the same DFA as DFA_canonical(), which is the smallest DFA with the same
+     * traces and final states.  Partial DFAs are minimized without completing them:
+     * an undefined transition stays undefined, and a state with undefined transitions
+     * is never merged with one whose transitions are defined.
+     *
+     * @param mapping Where to store the minimized state of every state of this DFA,
+     *      -1 for unreachable states; may be nullptr
+     * @return Pointer to the new minimized DFA, which shares this DFA's alphabet
+     */
+    dfa *DFA_minimize(std::vector<int> *mapping) const;
+
+    /** @brief Computes the digest of the canonical form of the DFA
+     *
+     * @return DFA_digest() of DFA_canonical()
+     */
+    dfa_digest_t DFA_canonical_digest() const;
+
     /** @brief Prints information representing the construction of the DFA to specified file
      *
      * @param f File pointer for output
@@ -130,13 +315,38 @@ public:
     void DFA_print(FILE *f) const;
 
     /** @brief Applies a symbol to a DFA from a given state
+     *
+     * Thin wrapper around apply() which first resolves the symbol to its index; prefer
+     * apply() when the symbol index is already known.
      *
      * @param current_state state on which to execute
      * @param symbol Symbol to use in execution
      * @return destination state or negative error code on error
      */
     int DFA_apply_symbol(int current_state, const std::string& symbol);
+
+    /** @brief Applies a symbol, given by its index in the alphabet, from a given state
+     *
+     * @param state State on which to execute, must be valid
+     * @param symbol_index Index of the symbol in the alphabet, must be valid
+     * @return destination state or DFA_DUMMY_SYMBOL if the transition does not exist
+     */
+    int apply(int state, int symbol_index) const {
+        return this->transition_matrix[(size_t) state * this->alphabet_size + symbol_index];
+    }
 };
 
+/** @brief Builds the union of the alphabets of two DFAs
+ *
+ * Symbols are ordered by name so that the result does not depend on the order in
+ * which symbols happened to be interned.  This is the alphabet of the parallel
+ * composition of the two DFAs.
+ *
+ * @param dfa_1 First DFA
+ * @param dfa_2 Second DFA
+ * @return Alphabet containing every symbol of either DFA
+ */
+std::shared_ptr<const dfa_alphabet> DFA_union_alphabet(const dfa& dfa_1, const dfa& dfa_2);
+
 #endif /* __VERIF_DFA_H__ */
 
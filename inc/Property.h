@@ -4,20 +4,81 @@
  *
  *  This serves as an implementation of properties, including the key
  *  functionality of checking whether a dfa satisfies a property
+ *
+ *  The property states from which an error state can still be reached are found
+ *  once, when the property is constructed.  Checks never go on from a state whose
+ *  property state is not one of them, and a property whose initial state is not
+ *  one of them is satisfied by everything without a search.
  */
 
 #ifndef __VERIF_PROPERTY_H__
 #define __VERIF_PROPERTY_H__
 
+#include <memory>
 #include "DFA.h"
+#include "bitset_check.h"
+#include "check_workspace.h"
 
 typedef enum class interps { NOP, ERROR } interps_t;
 
+/* Shortest trace that drives a composition into an error state of a property */
+typedef struct counterexample {
+    std::vector<int> symbols;   /* Interned IDs of the symbols of the trace, in order */
+    std::vector<std::vector<int>> states;   /* states[c][i] is the state of component c
+                                 * after the first i symbols; components are the checked
+                                 * DFAs in argument order, then the property */
+} counterexample_t;
+
+/* Symbols of the compositions checked against a property, see Property.cpp */
+struct composition_cache;
+
+/** @brief Builds a counterexample from a traced breadth-first search
+ *
+ * The last key popped from the workspace must be the one the error was found from.
+ * Keys are unpacked in mixed radix, with the first component most significant.
+ *
+ * @param workspace Workspace of the search, which must have been reset with tracing
+ * @param sizes Number of states of each component packed into the keys
+ * @param symbol_ids Interned ID of each symbol index used in the search
+ * @param symbol Symbol index of the edge into the error state
+ * @param error_key Key of the error state
+ * @param trace Where to store the counterexample
+ */
+void counterexample_build(const check_workspace &workspace, const std::vector<uint64_t> &sizes,
+        const std::vector<int> &symbol_ids, int symbol, uint64_t error_key, counterexample_t *trace);
+
+/** @brief Recomputes the states of one component of a counterexample by running its
+ *      symbols through a DFA
+ *
+ * Reports a counterexample found on a minimized component (see DFA_minimize) in terms
+ * of the original, which accepts the same traces.
+ *
+ * @param trace Counterexample to update
+ * @param component Index of the component in trace->states
+ * @param M DFA of the component, with the same traces as the one the trace was found on
+ */
+void counterexample_replay(counterexample_t *trace, int component, const dfa &M);
+
+/** @brief Prints a counterexample, one step per line
+ *
+ * @param trace Counterexample to print
+ * @param f File to print to
+ */
+void counterexample_print(const counterexample_t &trace, FILE *f);
+
 class Property {
 private:
     dfa *sim_dfa; /* DFA simulating the property */
     interps_t invalid_interp; /* Mode to interpret */
     std::set<int> error_states; /* states which represent errors */
+    std::vector<bool> error_lookup; /* error_lookup[s] is true iff s is an error state */
+    std::vector<bool> coreachable; /* coreachable[s] is true iff an error state can be
+                                    * reached from s in the property DFA */
+    check_workspace workspace; /* Search storage reused by checks without their own */
+    check_engine_t engine; /* Engine of property_check(M) */
+    std::shared_ptr<const bitset_checker> bitset; /* Masks of the property, for the bitset engine */
+    std::shared_ptr<composition_cache> compositions; /* Symbols of the composition checked
+                                    * last, shared by copies of the property */
 //    int *error_states; /* states which represent errors */
 //    int num_error_states; /* number of error states */
 public:
@@ -35,12 +96,104 @@ public:
      */
     void property_print();
 
+    /** @brief Returns the DFA simulating the property
+     *
+     * @return The property DFA
+     */
+    dfa& get_dfa() const { return *this->sim_dfa; }
+
+    /** @brief Returns whether a state of the property DFA is an error state
+     *
+     * @param state State of the property DFA, must be valid
+     * @return True if reaching the state violates the property
+     */
+    bool is_error_state(int state) const { return this->error_lookup[state]; }
+
+    /** @brief Returns whether an error state can be reached from a state of the property DFA
+     *
+     * Computed once, over every transition of the property DFA whatever a composition
+     * allows.  A search never needs to go on from a state where this is false.
+     *
+     * @param state State of the property DFA, must be valid
+     * @return True if some trace leads from the state to an error state
+     */
+    bool can_reach_error(int state) const { return this->coreachable[state]; }
+
+    /** @brief Returns whether any composition at all can violate the property
+     *
+     * If not, every check is satisfied without exploring anything.
+     *
+     * @return True if an error state can be reached from the initial state
+     */
+    bool can_be_violated() const { return this->coreachable[this->sim_dfa->initial_state]; }
+
+    /** @brief Selects the engine that property_check(M) runs on
+     *
+     * The breadth-first engine is the default.  The bitset engine (see bitset_check.h)
+     * explores sets of states at a time, and is only used for checks that record no
+     * counterexample; checks of the composition of two DFAs are always breadth-first.
+     *
+     * @param engine Engine to use
+     */
+    void set_engine(check_engine_t engine);
+
     /** @brief Checks if a DFA satisfies the property
+     *
+     * @note Uses storage owned by the property, so concurrent checks against the same
+     *          property must each pass their own workspace instead
      *
      * @param dfa State machine to check the property on
      * @return True if the property is satisfied, false if not
      */
     bool property_check(dfa &M);
+
+    /** @brief Checks if a DFA satisfies the property, using the given search storage
+     *
+     * If a trace is requested, the search also records how every state was reached,
+     * and on a violation the shortest violating trace is stored without searching
+     * again; trace->states holds the states of M and of the property.
+     *
+     * @param dfa State machine to check the property on
+     * @param workspace Storage for the visited set and frontier
+     * @param trace Where to store a counterexample on a violation, or nullptr
+     * @return True if the property is satisfied, false if not
+     */
+    bool property_check(dfa &M, check_workspace &workspace, counterexample_t *trace = nullptr);
+
+    /** @brief Checks if the parallel composition of two DFAs satisfies the property
+     *
+     * Equivalent to property_check(dfa(M1, M2)), but the composition is never built:
+     * (M1 state, M2 state, property state) tuples are explored on the fly, so only the
+     * reachable part of the product is ever visited and nothing proportional to the
+     * full product is allocated.
+     *
+     * @note Uses storage owned by the property, so concurrent checks against the same
+     *          property must each pass their own workspace instead
+     *
+     * @param M1 First component, typically the human model
+     * @param M2 Second component, typically the machine
+     * @return True if the property is satisfied, false if not
+     */
+    bool property_check(dfa &M1, dfa &M2);
+
+    /** @brief Checks if the parallel composition of two DFAs satisfies the property,
+     *      using the given search storage
+     *
+     * If a trace is requested, the shortest violating trace is stored on a violation;
+     * trace->states holds the states of M1, M2 and the property.
+     *
+     * The symbols of the composition are kept, so checks of DFAs with the same two
+     * alphabets as the last check, such as the modifications of one model against a
+     * machine, only build the union of the alphabets once.
+     *
+     * @param M1 First component, typically the human model
+     * @param M2 Second component, typically the machine
+     * @param workspace Storage for the visited set and frontier
+     * @param trace Where to store a counterexample on a violation, or nullptr
+     * @return True if the property is satisfied, false if not
+     */
+    bool property_check(dfa &M1, dfa &M2, check_workspace &workspace,
+            counterexample_t *trace = nullptr);
 };
 
 
@@ -0,0 +1,69 @@
+/** @file arena.h
+ *  @brief Header for bump allocation of short-lived arrays
+ *  @author Brian Wei
+ *
+ *  An arena hands out storage for the temporary arrays of one search or trial
+ *  by bumping an offset through a block of memory.  Nothing is freed on its own;
+ *  reset() releases everything at once by rewinding the offset.  An allocation
+ *  that does not fit adds a larger block.  The next reset() replaces all blocks
+ *  with one block as large as all of them.  A repeated workload therefore runs
+ *  from a single block, and each reset is O(1) with no calls to the allocator.
+ *
+ *  Only trivial types can be allocated, since no constructors or destructors
+ *  are run.
+ */
+
+#ifndef __VERIF_ARENA_H__
+#define __VERIF_ARENA_H__
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/* Size of the first block of an arena, in bytes */
+#define ARENA_INITIAL_SIZE  (1 << 16)
+
+/* Alignment of every allocation, in bytes */
+#define ARENA_ALIGN         (alignof(std::max_align_t))
+
+class arena {
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;    /* Blocks in order of addition */
+    std::vector<size_t> sizes;      /* Size of each block, in bytes */
+    size_t used;                    /* Bytes used in the last block */
+
+    /** @brief Adds a block large enough for an allocation and allocates from it
+     *
+     * @param bytes Size of the allocation
+     * @return Start of the allocation
+     */
+    char *grow(size_t bytes);
+public:
+    /** @brief Constructs an arena with no blocks
+     */
+    arena();
+
+    /** @brief Returns uninitialized storage for an array, valid until the next reset()
+     *
+     * @param count Number of elements
+     * @return First element of the array
+     */
+    template <class T>
+    T *allocate(size_t count) {
+        static_assert(std::is_trivial<T>::value, "arenas only hold trivial types");
+        size_t bytes = count * sizeof(T);
+        size_t start = (this->used + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+        if (!this->blocks.empty() && start + bytes <= this->sizes.back()) {
+            this->used = start + bytes;
+            return reinterpret_cast<T*>(this->blocks.back().get() + start);
+        }
+        return reinterpret_cast<T*>(this->grow(bytes));
+    }
+
+    /** @brief Releases every allocation at once
+     */
+    void reset();
+};
+
+#endif /* __VERIF_ARENA_H__ */
@@ -0,0 +1,62 @@
+/** @file batch_check.h
+ *  @brief Header for checking many mutants of one DFA together
+ *  @author Brian Wei
+ *
+ *  A modification campaign checks many mutants of one base DFA.  Each mutant
+ *  differs from the base only in the rows of a few states, so most of their
+ *  products with a monitored machine (see monitor.h) are the same.  The batched
+ *  checker explores the products of up to BATCH_MAX_LANES mutants in a single
+ *  search.  Each mutant is one lane of a 64-bit mask.  Every (human state,
+ *  monitored state) pair records the lanes in which it is reachable.  Masks are
+ *  only kept for pairs the search reaches, in a hash table from the workspace's
+ *  arena, so a batch costs what it explores rather than the full key space.
+ *
+ *  From a pair, the lanes whose mutant has the base's row for the human state
+ *  all move the same way, so they are passed on together as one mask.  Only
+ *  lanes whose row was changed are followed one at a time.  A lane is retired
+ *  as soon as its mutant reaches an error state, and the search stops once every
+ *  lane is retired.  The result for each lane is always the same as a full check
+ *  of its mutant.
+ */
+
+#ifndef __VERIF_BATCH_CHECK_H__
+#define __VERIF_BATCH_CHECK_H__
+
+#include <cstdint>
+#include <vector>
+#include "DFA.h"
+#include "check_workspace.h"
+#include "monitor.h"
+#include "mutant.h"
+
+/* Largest number of mutants checked together */
+#define BATCH_MAX_LANES     (64)
+
+class batch_checker {
+private:
+    const monitored_machine& monitor;   /* Machine and property composed with every mutant */
+    const dfa& base;                    /* DFA that the mutants are made from */
+    monitor_alignment_t alignment;      /* Symbols of the product */
+public:
+    /** @brief Prepares to check mutants of a base DFA
+     *
+     * @note The monitored machine and the base must outlive the checker
+     *
+     * @param monitor Monitored machine which every mutant is composed with
+     * @param base DFA that mutants are made from, typically the human model
+     */
+    batch_checker(const monitored_machine& monitor, const dfa& base);
+
+    /** @brief Checks if the compositions of some mutants and the machine satisfy the property
+     *
+     * Lane i of the result is the same as monitor.check() of mutants[i] built as a
+     * full DFA.
+     *
+     * @param mutants Views of at most BATCH_MAX_LANES mutants, each made from the base
+     * @param workspace Storage for the lane masks and frontier
+     * @return Mask with bit i set if mutants[i] satisfies the property
+     */
+    uint64_t check(const std::vector<const dfa_mutant*>& mutants, check_workspace& workspace) const;
+};
+
+#endif /* __VERIF_BATCH_CHECK_H__ */
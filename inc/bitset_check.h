@@ -0,0 +1,70 @@
+/** @file bitset_check.h
+ *  @brief Header for the bit-parallel property checking engine
+ *  @author Brian Wei
+ *
+ *  An alternative to the breadth-first engine of property_check, which works on
+ *  whole sets of product states at a time.  A check explores the product of a
+ *  left DFA (typically the human model) and a right DFA (a property or a
+ *  monitored machine).  For every left state, the frontier and visited sets hold
+ *  one bitset over the right DFA's states.
+ *
+ *  For each symbol, the successors of a row are computed with word operations on
+ *  precomputed per-symbol masks.  The right states that stay in place on the
+ *  symbol are kept with a single AND.  Only the states that actually move are
+ *  scattered bit by bit.  The error states are a mask too, so a set of successors
+ *  is tested for a violation with one AND per word.  Right states from which no
+ *  error state can be reached can be masked out of the frontier the same way.
+ *  The search is level by level and gives the same verdict as the breadth-first
+ *  engine, but records no counterexamples.
+ */
+
+#ifndef __VERIF_BITSET_CHECK_H__
+#define __VERIF_BITSET_CHECK_H__
+
+#include <cstdint>
+#include <vector>
+#include "DFA.h"
+#include "check_workspace.h"
+
+/* Engines which a property check can run on */
+typedef enum class check_engine { BFS, BITSET } check_engine_t;
+
+class bitset_checker {
+private:
+    int num_states;             /* Number of states of the right DFA */
+    int initial_state;          /* Initial state of the right DFA */
+    int num_words;              /* Words per bitset over the right DFA's states */
+    std::vector<uint64_t> live_mask;    /* Right states the frontier may hold */
+    std::vector<uint64_t> error_mask;   /* Error states of the right DFA */
+    std::vector<uint64_t> stay_masks;   /* Per symbol, right states the symbol leaves in place */
+    std::vector<uint64_t> move_masks;   /* Per symbol, right states the symbol moves elsewhere */
+    std::vector<int> targets;           /* Per symbol and right state, the destination */
+public:
+    /** @brief Precomputes the per-symbol masks of the right DFA
+     *
+     * @param right Right DFA, a property or a monitored machine
+     * @param error Whether each state of the right DFA is an error state
+     * @param undefined_stays Whether an undefined transition leaves the right DFA in
+     *      place (a property with NOP semantics) rather than blocking (a machine)
+     * @param live Whether an error state can be reached from each right state; other
+     *      states are never added to the frontier.  nullptr keeps every state
+     */
+    bitset_checker(const dfa& right, const std::vector<bool>& error, bool undefined_stays,
+            const std::vector<bool> *live = nullptr);
+
+    /** @brief Checks whether the product of a left DFA and the right DFA reaches an error
+     *
+     * Symbols are given as two aligned lists, with DFA_INVALID_SYMBOL (or any
+     * negative value) where a DFA lacks the symbol and therefore stays in place.
+     *
+     * @param left Left DFA, typically the human model
+     * @param left_symbols Left index of each symbol of the product
+     * @param right_symbols Right index of each symbol of the product
+     * @param workspace Storage for the bitsets and temporary arrays, which is reset
+     * @return True if no error state is reachable, false if one is
+     */
+    bool check(const dfa& left, const std::vector<int>& left_symbols,
+            const std::vector<int>& right_symbols, check_workspace& workspace) const;
+};
+
+#endif /* __VERIF_BITSET_CHECK_H__ */
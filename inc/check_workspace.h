@@ -0,0 +1,185 @@
+/** @file check_workspace.h
+ *  @brief Header for the reusable state storage of property checks
+ *  @author Brian Wei
+ *
+ *  A property check explores product states, each of which is packed into a
+ *  single 64-bit key.  The workspace holds the visited set and the frontier for
+ *  such a search.  The visited set is a flat bitmap when the key space is small
+ *  enough, and otherwise an open-addressing hash table.  The frontier is a ring
+ *  buffer.  All storage is kept between checks, so once a workspace has grown to
+ *  the size of a model, later checks do not allocate at all.  The workspace
+ *  remembers which bitmap words and table slots a search set, and a reset only
+ *  clears those, so a check costs what it visits rather than its key space.
+ *
+ *  A search can optionally record, for every key pushed, the frontier position
+ *  of the key it was reached from and the symbol it was reached by.  Positions
+ *  count pushes and pops since the reset, so the key being expanded is always
+ *  the last one popped.  When a breadth-first search finds an error, the path
+ *  to it can then be read back without searching again.
+ *
+ *  Other temporary arrays of a search come from the workspace's arena (see
+ *  arena.h), which every reset() releases in O(1).
+ */
+
+#ifndef __VERIF_CHECK_WORKSPACE_H__
+#define __VERIF_CHECK_WORKSPACE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "arena.h"
+
+/* Largest key space, in keys, for which the visited set is a bitmap (8 MB) */
+#define WORKSPACE_MAX_BITMAP_KEYS   (1ULL << 26)
+
+/** @brief Mixes the bits of a key for use as a hash table position
+ *
+ * @param key Key to hash
+ * @return Hash of the key
+ */
+static inline uint64_t workspace_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+class check_workspace {
+private:
+    bool dense;                     /* Whether the visited set is the bitmap */
+    std::vector<uint64_t> bitmap;   /* Visited bitmap, one bit per key; may be longer
+                                     * than the current key space needs */
+    std::vector<uint64_t> bitmap_words; /* Bitmap words set since the last reset */
+    std::vector<uint64_t> table;    /* Open-addressing visited table, key + 1 per slot
+                                     * and 0 for an empty slot; size is a power of two */
+    std::vector<uint64_t> table_slots;  /* Table slots filled since the last reset */
+    std::vector<uint64_t> ring;     /* Frontier ring buffer; size is a power of two */
+    uint64_t head;                  /* Position of the next key to pop; positions count
+                                     * from the reset and are never rebased */
+    uint64_t tail;                  /* Position one past the last key pushed */
+    bool tracing;                   /* Whether pushes are recorded in the trace log */
+    std::vector<uint64_t> trace_keys;   /* Key pushed at each position, when tracing */
+    std::vector<int64_t> trace_parents; /* Position each key was reached from, or -1 */
+    std::vector<int> trace_symbols;     /* Symbol each key was reached by, or -1 */
+    std::vector<uint64_t> bits;     /* Bitset storage of the bitset engine; zero apart
+                                     * from the marked ranges */
+    std::vector<std::pair<size_t, size_t>> bits_marked; /* First word and number of words
+                                     * of each range marked since the last bitsets() */
+    arena temporary;                /* Temporary arrays of the current search */
+
+    /* Doubles the size of the hash table, reinserting all keys */
+    void grow_table();
+
+    /* Doubles the size of the ring buffer, keeping the queued keys at their positions */
+    void grow_ring();
+
+    /* Inserts a key into the hash table, returning whether it was not there yet */
+    bool table_insert(uint64_t key);
+public:
+    /** @brief Constructs an empty workspace
+     */
+    check_workspace();
+
+    /** @brief Empties the visited set and the frontier for a new search, and releases
+     *      every temporary array
+     *
+     * @param key_space Number of possible keys, keys must lie in [0, key_space)
+     * @param tracing Whether to record how every pushed key was reached
+     */
+    void reset(uint64_t key_space, bool tracing = false);
+
+    /** @brief Marks a key as visited
+     *
+     * @param key Key to mark
+     * @return True if the key had not been visited before
+     */
+    bool visit(uint64_t key) {
+        if (this->dense) {
+            uint64_t bit = 1ULL << (key & 63);
+            uint64_t &word = this->bitmap[key >> 6];
+            if (word & bit) return false;
+            if (word == 0) this->bitmap_words.push_back(key >> 6);
+            word |= bit;
+            return true;
+        }
+        return this->table_insert(key);
+    }
+
+    /** @brief Adds a key to the back of the frontier
+     *
+     * When tracing, the key is recorded as reached from the last key popped.
+     *
+     * @param key Key to add
+     * @param symbol Symbol the key was reached by, only used when tracing
+     */
+    void push(uint64_t key, int symbol = -1) {
+        if (this->tail - this->head == this->ring.size()) this->grow_ring();
+        this->ring[this->tail++ & (this->ring.size() - 1)] = key;
+        if (this->tracing) {
+            this->trace_keys.push_back(key);
+            this->trace_parents.push_back((int64_t) this->head - 1);
+            this->trace_symbols.push_back(symbol);
+        }
+    }
+
+    /** @brief Removes the key at the front of the frontier, which must not be empty
+     *
+     * @return The removed key
+     */
+    uint64_t pop() {
+        return this->ring[this->head++ & (this->ring.size() - 1)];
+    }
+
+    /** @brief Returns whether the frontier is empty
+     *
+     * @return True if there are no keys left to pop
+     */
+    bool empty() const {
+        return this->head == this->tail;
+    }
+
+    /** @brief Reads back the path to the last key popped, which must have been traced
+     *
+     * @param keys Where to store the keys of the path, from the first key pushed
+     * @param symbols Where to store the symbols between them, one fewer than the keys
+     */
+    void trace_back(std::vector<uint64_t> &keys, std::vector<int> &symbols) const;
+
+    /** @brief Returns zeroed storage for the bitsets of a bitset engine search
+     *
+     * The storage is separate from the visited set and frontier, and is valid until
+     * the next call.  It is kept between searches, and only the ranges marked by the
+     * last search are cleared, so a search must mark every word it may set.
+     *
+     * @param words Number of 64-bit words needed
+     * @return Pointer to the first word
+     */
+    uint64_t *bitsets(size_t words);
+
+    /** @brief Marks a range of the bitsets as possibly set, to be cleared by the next
+     *      bitsets() call
+     *
+     * @param first Index of the first word of the range
+     * @param count Number of words in the range
+     */
+    void bitsets_mark(size_t first, size_t count) {
+        this->bits_marked.emplace_back(first, count);
+    }
+
+    /** @brief Returns uninitialized storage for a temporary array of the current search
+     *
+     * The storage is valid until the next reset().
+     *
+     * @param count Number of elements
+     * @return First element of the array
+     */
+    template <class T>
+    T *allocate(size_t count) {
+        return this->temporary.allocate<T>(count);
+    }
+};
+
+#endif /* __VERIF_CHECK_WORKSPACE_H__ */
@@ -0,0 +1,158 @@
+/** @file dfa_file.h
+ *  @brief Header for the binary DFA file format
+ *  @author Brian Wei
+ *
+ *  A compact, versioned binary format for DFAs which can be memory-mapped and
+ *  used in place.  All fields are in the byte order of the machine that wrote
+ *  the file, which is recorded in the header; each section starts on an 8 byte
+ *  boundary.  The layout is:
+ *
+ *      header      dfafile_header_t
+ *      alphabet    alphabet_size uint32 offsets into the name block, followed
+ *                  by the name block of null terminated symbol names
+ *      table       num_states * alphabet_size int32 transitions, row-major as
+ *                  in dfa::transition_matrix, DFA_DUMMY_SYMBOL if undefined
+ *      finals      ceil(num_states / 64) uint64 words, bit s set if s is final
+ *      errors      same as finals, bit s set if s is an error state
+ *
+ *  The error bitmap lets a property DFA be stored together with its error
+ *  states; it is all zero for other DFAs.
+ *
+ *  A dfa_view validates a file and reads it in place, which is enough to inspect
+ *  a model without copying it.  Checks and compositions work on dfa objects
+ *  only, so a model to be checked is copied into a dfa once, by to_dfa() or
+ *  dfafile_load(); that copy is a single pass over the mapped table, which still
+ *  saves the parsing of the LTSA text.
+ */
+
+#ifndef __VERIF_DFA_FILE_H__
+#define __VERIF_DFA_FILE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include "DFA.h"
+
+#define DFAFILE_NO_ERROR        (0)
+#define DFAFILE_IO_ERROR        (-1)
+#define DFAFILE_BAD_FORMAT      (-2)
+#define DFAFILE_BAD_VERSION     (-3)
+
+#define DFAFILE_MAGIC           "VERIFDFA"
+#define DFAFILE_VERSION         (1)
+#define DFAFILE_BYTE_ORDER      (0x01020304)
+
+/* Header at the start of every binary DFA file */
+typedef struct dfafile_header {
+    char magic[8];              /* DFAFILE_MAGIC, without the null terminator */
+    uint32_t version;           /* DFAFILE_VERSION */
+    uint32_t byte_order;        /* DFAFILE_BYTE_ORDER as written by the writer */
+    int32_t num_states;         /* Number of states */
+    int32_t alphabet_size;      /* Number of symbols */
+    int32_t initial_state;      /* Initial state */
+    uint32_t names_size;        /* Size of the name block, in bytes */
+    uint64_t alphabet_offset;   /* Offset of the alphabet section */
+    uint64_t table_offset;      /* Offset of the transition table */
+    uint64_t finals_offset;     /* Offset of the final state bitmap */
+    uint64_t errors_offset;     /* Offset of the error state bitmap */
+    uint64_t file_size;         /* Size of the whole file, in bytes */
+} dfafile_header_t;
+
+/* Read-only view of a DFA in a memory-mapped binary file; nothing is copied, so
+ * opening a file costs the same whatever its size, apart from validation.  The
+ * view is a validating loader, not something checks run on; see to_dfa() */
+class dfa_view {
+private:
+    void *mapping;              /* Memory mapping of the file, or nullptr */
+    size_t mapping_size;        /* Size of the mapping */
+    const dfafile_header_t *header;     /* Header of the file */
+    const uint32_t *name_offsets;       /* Offset of each symbol name in names */
+    const char *names;                  /* Name block */
+    const int32_t *table;               /* Transition table */
+    const uint64_t *finals;             /* Final state bitmap */
+    const uint64_t *errors;             /* Error state bitmap */
+public:
+    /** @brief Constructs a view of no file
+     */
+    dfa_view();
+
+    /** @brief Unmaps the file, if any
+     */
+    ~dfa_view();
+
+    dfa_view(const dfa_view&) = delete;
+    dfa_view& operator=(const dfa_view&) = delete;
+
+    /** @brief Maps and validates a binary DFA file, replacing any file already open
+     *
+     * @param path Path to the file
+     * @return DFAFILE_NO_ERROR on success, negative error code on failure
+     */
+    int open(const char *path);
+
+    /** @brief Unmaps the file, if any
+     */
+    void close();
+
+    int num_states() const { return this->header->num_states; }
+    int alphabet_size() const { return this->header->alphabet_size; }
+    int initial_state() const { return this->header->initial_state; }
+
+    /** @brief Returns the destination of a transition
+     *
+     * @param state Source state
+     * @param symbol_index Alphabet index of the symbol
+     * @return Destination state, or DFA_DUMMY_SYMBOL if undefined
+     */
+    int apply(int state, int symbol_index) const {
+        return this->table[(size_t) state * this->header->alphabet_size + symbol_index];
+    }
+
+    bool is_final(int state) const { return (this->finals[state >> 6] >> (state & 63)) & 1; }
+    bool is_error(int state) const { return (this->errors[state >> 6] >> (state & 63)) & 1; }
+
+    /** @brief Returns the name of a symbol, pointing into the mapped file
+     *
+     * @param symbol_index Alphabet index of the symbol
+     * @return Null terminated name
+     */
+    const char *symbol_name(int symbol_index) const {
+        return this->names + this->name_offsets[symbol_index];
+    }
+
+    /** @brief Copies the viewed DFA into a new dfa, interning its alphabet
+     *
+     * @param error_states Where to store the error states, or nullptr
+     * @return Pointer to the new DFA
+     */
+    dfa *to_dfa(std::set<int> *error_states) const;
+};
+
+/** @brief Writes a DFA to a binary file
+ *
+ * @param path Path to the file, which is replaced if it exists
+ * @param M DFA to write
+ * @param error_states Error states to record, e.g. those of a property
+ * @return DFAFILE_NO_ERROR on success, negative error code on failure
+ */
+int dfafile_write(const char *path, const dfa &M, const std::set<int> &error_states);
+
+/** @brief Reads a binary file into a new DFA
+ *
+ * @param path Path to the file
+ * @param error_states Where to store the error states, or nullptr
+ * @return Pointer to the new DFA, or nullptr if the file cannot be read or is invalid
+ */
+dfa *dfafile_load(const char *path, std::set<int> *error_states);
+
+/** @brief Converts LTSA output (see ltsa_parser.h) to a binary file
+ *
+ * @param ltsa_path Path to the LTSA output
+ * @param path Path to the binary file to write
+ * @param error_states Error states to record
+ * @return DFAFILE_NO_ERROR on success, DFAFILE_BAD_FORMAT if the LTSA output cannot be
+ *      parsed, DFAFILE_IO_ERROR if the binary file cannot be written
+ */
+int dfafile_convert(const char *ltsa_path, const char *path, const std::set<int> &error_states);
+
+#endif /* __VERIF_DFA_FILE_H__ */
@@ -52,6 +52,61 @@ dfa *ex_cycle(int size);
  */
 dfa *ex_cdm();
 
+/* Scalable generators; symbols are named S0, S1, ... so that generated DFAs with
+ * the same alphabet size share their alphabet */
+
+/** @brief Generates a random DFA
+ *
+ * Each transition is defined with probability density, to a uniformly random state.
+ * State 0 is initial and no state is final.
+ *
+ * @param size Number of states
+ * @param alphabet_size Number of symbols
+ * @param density Probability that a transition is defined, in [0, 1]
+ * @param seed Seed of the generator, equal arguments give equal DFAs
+ * @return Pointer to the new DFA
+ */
+dfa *ex_random(int size, int alphabet_size, double density, unsigned seed);
+
+/** @brief Generates a ring where symbol k steps k + 1 states forward
+ *
+ *   e.g. size = 4, alphabet_size = 2
+ *
+ *      +---+          +---+          +---+          +---+
+ *      | 0 |--(S0)--->| 1 |--(S0)--->| 2 |--(S0)--->| 3 |
+ *      +---+          +---+          +---+          +---+
+ *        ^                                            |
+ *        +-------------------(S0)---------------------+
+ *
+ *      and S1 goes from i to i + 2 (mod 4)
+ *
+ * @param size Number of states
+ * @param alphabet_size Number of symbols
+ * @return Pointer to the new DFA
+ */
+dfa *ex_ring(int size, int alphabet_size);
+
+/** @brief Generates a pump: a prefix chain, a loop, and a final sink
+ *
+ *   e.g. size = 5, alphabet_size = 2
+ *
+ *      +---+          +---+          +---+          +---+
+ *      | 0 |--(S0)--->| 1 |--(S1)--->| 2 |--(S1)--->| 3 |
+ *      +---+          +---+          +---+          +---+
+ *                       ^                             |
+ *                       +------------(S1)-------------+
+ *
+ *      and S0 goes from each of 1, 2 and 3 to the final sink 4
+ *
+ * A quarter of the other states form the prefix, taken by S0.  The loop is
+ * driven by S1, and each further symbol k steps k - 1 states back around it.
+ *
+ * @param size Number of states, at least 3
+ * @param alphabet_size Number of symbols, at least 2
+ * @return Pointer to the new DFA
+ */
+dfa *ex_pump(int size, int alphabet_size);
+
 /* Patterns */
 
 /** @brief Three state pattern with two symbols linear
@@ -93,10 +148,22 @@ dfa *prop_five();
 
 dfa *ex_fancy();
 
+/** @brief Loads the infusion pump machine from ltsa_models/
+ *
+ * @return Pointer to the new DFA, or nullptr if the model cannot be read
+ */
 dfa *ex_infusion();
 
+/** @brief Loads the infusion pump human model from ltsa_models/
+ *
+ * @return Pointer to the new DFA, or nullptr if the model cannot be read
+ */
 dfa *ex_human();
 
+/** @brief Loads the infusion pump property from ltsa_models/
+ *
+ * @return Pointer to the new DFA, or nullptr if the model cannot be read
+ */
 dfa *ex_prop();
 
 #endif /* __VERIF_EXAMPLES_H__ */
@@ -0,0 +1,63 @@
+/** @file incremental_check.h
+ *  @brief Header for incremental property checking of modified DFAs
+ *  @author Brian Wei
+ *
+ *  A modification campaign checks many mutants of one base DFA.  Each mutant
+ *  differs from the base only in the rows of a few touched states.  The
+ *  incremental checker explores the reachable product of the base DFA and a
+ *  monitored machine (see monitor.h) once, and keeps it.
+ *
+ *  For a mutant, every base state whose breadth-first tree path never leaves a
+ *  touched DFA state is still reachable through that same path.  Those states
+ *  are marked visited without being expanded.  Only the rest of the mutant's
+ *  product is explored: the touched states themselves, plus base states entered
+ *  by an unchanged edge from a still-reachable state.  The result is always the
+ *  same as a full check.
+ */
+
+#ifndef __VERIF_INCREMENTAL_CHECK_H__
+#define __VERIF_INCREMENTAL_CHECK_H__
+
+#include <cstdint>
+#include <vector>
+#include "DFA.h"
+#include "check_workspace.h"
+#include "monitor.h"
+#include "mutant.h"
+
+class incremental_checker {
+private:
+    const monitored_machine& monitor;   /* Machine and property composed with every mutant */
+    int base_num_states;        /* Number of states of the base DFA */
+    std::shared_ptr<const dfa_alphabet> base_alphabet; /* Alphabet of the base DFA */
+    monitor_alignment_t alignment;      /* Symbols of the product */
+    bool base_satisfied;        /* Whether the base itself satisfies the property */
+
+    /* Reachable product of the base, states numbered in breadth-first order */
+    std::vector<uint64_t> keys;         /* Packed key of each state */
+    std::vector<int> base_state;        /* Base DFA component of each state */
+    std::vector<int> parent;            /* Breadth-first tree parent, -1 for the root */
+    std::vector<int> pred_start;        /* Start of each state's predecessors in preds */
+    std::vector<int> preds;             /* Predecessors of every state, grouped by state */
+public:
+    /** @brief Explores and keeps the reachable product of a base DFA
+     *
+     * @note The monitored machine must outlive the checker
+     *
+     * @param monitor Monitored machine which every mutant is composed with
+     * @param base DFA that mutants are made from, typically the human model
+     */
+    incremental_checker(const monitored_machine& monitor, dfa& base);
+
+    /** @brief Checks if the composition of a mutant and the machine satisfies the property
+     *
+     * Same result as monitor.check() of the mutant built as a full DFA.
+     *
+     * @param mutant View of a mutant whose base is the checker's base
+     * @param workspace Storage for the visited set and frontier
+     * @return True if the property is satisfied, false if not
+     */
+    bool check(const dfa_mutant& mutant, check_workspace& workspace) const;
+};
+
+#endif /* __VERIF_INCREMENTAL_CHECK_H__ */
@@ -2,7 +2,10 @@
  *  @brief Header file for LTSA parser
  *  @author Brian Wei
  *
- *  Parses the output format created by the LTSA tool into the DFA structure
+ *  Parses the output format created by the LTSA tool into the DFA structure.
+ *  The file is memory-mapped (or read in chunks if it cannot be mapped) and
+ *  tokenized in a single pass into a flat list of edges, from which the
+ *  transition table is built directly.
  */
 
 #ifndef __VERIF_LTSA_PARSER_H__
@@ -12,9 +15,12 @@
 
 /** @brief Parses the LTSA output into dfa
  *
- * @param dfa DFA to put the output into
+ * States are numbered in the order they are listed.  If a state lists a symbol
+ * more than once, the first transition is kept.  States that STOP loop on every
+ * symbol, and transitions to ERROR are left undefined.
+ *
  * @param path Relative path to the LTSA output file
- * @return zero on success, negative error code on failure
+ * @return Pointer to the new DFA, or nullptr if the file cannot be read or is malformed
  */
 dfa *parser_go(const char *path);
 
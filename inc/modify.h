@@ -20,6 +20,9 @@
 #define MODIFY_MEMORY_ERR   (-2)
 #define MODIFY_NOT_FOUND    (-3)
 
+/* Largest number of pattern instances rewritten together in one modification */
+#define MODIFY_MAX_ORDER    (4)
+
 /* Structure for pattern maps -- DFAs for the initial and target
  * configurations */
 typedef struct pattern_map {
@@ -30,11 +33,60 @@ typedef struct pattern_map {
 /* type definition for mapping_list -- a list of pattern maps */
 typedef std::vector<pattern_map_t*> mapping_list;
 
+/* Options for a modification campaign */
+typedef struct modify_options {
+    int num_threads;    /* Number of worker threads; 1 runs serially and 0 or less
+                         * uses one thread per hardware core */
+    bool incremental;   /* Whether to keep the unmodified DFA's reachable product and
+                         * only re-explore what each modification can change */
+    bool precompose;    /* Whether to compose the machine with the property once and
+                         * check every modification against that monitored machine;
+                         * always done for incremental campaigns */
+    const char *monitor_cache;  /* Path of a file holding the monitored machine between
+                         * campaigns, or nullptr; it is loaded if it is the composition
+                         * of this machine and property (see monitor_load), and is
+                         * otherwise composed and saved there */
+    bool traces;        /* Whether to save the shortest counterexample of every violating
+                         * modification next to it, as <n>.trace; such checks search
+                         * from the initial state, so they are never incremental */
+    bool binary;        /* Whether to also save every violating modification in the
+                         * binary format of dfa_file.h, as <n>.dfa */
+    bool dedupe;        /* Whether to check each distinct modification only once; a
+                         * modification whose canonical form (see DFA_canonical) was
+                         * already checked reuses that verdict.  Off by default: the
+                         * canonical form of every modification costs far more than
+                         * a check against the monitored machine.  The printed count
+                         * of skipped duplicates covers first-order modifications only */
+    bool minimize_machine;  /* Whether to minimize the machine (see DFA_minimize) once
+                         * before checking anything against it */
+    bool slice_machine; /* Whether to hide the machine's actions that neither the
+                         * property nor the modified DFA has (see slice.h) once before
+                         * checking anything against it; done before minimizing.
+                         * Saved traces then have the fewest relevant steps, which
+                         * may not make them the shortest overall */
+    bool minimize_mutants;  /* Whether to minimize every modification before checking
+                         * it; such checks are never incremental */
+    int batch_size;     /* Number of modifications checked together by one search (see
+                         * batch_check.h), at most BATCH_MAX_LANES; 1 checks them one
+                         * at a time.  Batches are not used with traces or minimized
+                         * modifications, and replace incremental checks otherwise */
+    check_engine_t engine;  /* Engine of the checks against the monitored machine (see
+                         * bitset_check.h); incremental checks and checks that save
+                         * a trace are breadth-first whatever the engine */
+    int order;          /* Largest number of pattern instances rewritten together in one
+                         * modification, at most MODIFY_MAX_ORDER; 1 rewrites a single
+                         * instance, see modify_violate_property for higher orders */
+    long max_trials;    /* Limit on the number of higher-order modifications checked,
+                         * 0 for no limit */
+    double time_limit;  /* Limit on the time spent on higher-order modifications, in
+                         * seconds, 0 for no limit */
+} modify_options_t;
+
 /** Create a new pattern map
  *
  * @param pattern1 First pattern, the initial pattern in the map
  * @param pattern2 Second pattter, the target pattern in the map
- * @return a pointer to a pattern_map; created via malloc
+ * @return a pointer to a pattern_map; created with new
  */
 pattern_map_t *modify_new_pattern_map(dfa &pattern1, dfa &pattern2);
 
@@ -51,6 +103,12 @@ mapping_list modify_new_mapping();
  */
 void modify_add_to_mappings(mapping_list &current_map, pattern_map_t &next);
 
+/** @brief Returns the default campaign options
+ *
+ * @return Options for a serial, incremental campaign
+ */
+modify_options_t modify_default_options();
+
 /** @brief Modify a DFA such that it will violate a property
  *
  * Make modifications to the modification DFA such that its parallel composition with the
@@ -70,4 +128,32 @@ void modify_add_to_mappings(mapping_list &current_map, pattern_map_t &next);
 int modify_violate_property(dfa &modification_dfa, dfa &machine_dfa, Property *p,
         mapping_list *maps, int max_per_map);
 
+/** @brief Modify a DFA such that it will violate a property, with campaign options
+ *
+ * As modify_violate_property above.  Each (map, trial) pair is an independent work
+ * item, and items are spread across options.num_threads worker threads.  Results
+ * are reported, and output files numbered, in (map, trial) order once all work is
+ * done, so the report does not depend on the number of threads.
+ *
+ * With options.order above 1, first-order modifications which satisfy the property
+ * are then combined, up to options.order at a time.  Only instances on disjoint states
+ * are combined; those commute, so each set is tried once, in one order.  A set that
+ * contains a smaller violating set is skipped, as is one equivalent to a modification
+ * already checked.  Sets are tried in order of how closely their first-order parts
+ * came to an error state, all pairs before any triple, until options.max_trials or
+ * options.time_limit is reached.  Violating sets are saved after the first-order
+ * modifications and counted with them.  The search runs on the calling thread.
+ *
+ * @param modification_dfa DFA that will be modified, typically the human model
+ * @param machine_dfa DFA representing the machine
+ * @param p Property that is aimed to be violated
+ * @param maps List of pattern maps that can be used
+ * @param max_per_map Limit on the number of attempted modifications per map
+ * @param options Campaign options
+ * @return zero on success, negative error code on error or if no violating modifications
+ *          are found
+ */
+int modify_violate_property(dfa &modification_dfa, dfa &machine_dfa, Property *p,
+        mapping_list *maps, int max_per_map, const modify_options_t &options);
+
 #endif /* __VERIF_MODIFY_H__ */
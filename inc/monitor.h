@@ -0,0 +1,161 @@
+/** @file monitor.h
+ *  @brief Header for monitored machines
+ *  @author Brian Wei
+ *
+ *  A monitored machine is the parallel composition of a machine with a property,
+ *  with the error states of the property marked.  It is built once, from the
+ *  reachable part of the composition only.  Any human model can then be checked
+ *  against it with a two-way exploration of (human state, monitored state)
+ *  pairs, instead of the three-way exploration of property_check(M1, M2).
+ *
+ *  The property is composed with NOP semantics.  A symbol the property does not
+ *  define from its current state leaves it where it is.  A symbol that only the
+ *  property knows is kept in the alphabet but never fires during a check,
+ *  because neither the human nor the machine can perform it.
+ *
+ *  Transitions into property states from which no error state can be reached
+ *  are left out of the monitored machine (see Property::can_reach_error), since
+ *  nothing after them can violate the property.  Every check against the
+ *  monitored machine is pruned the same way, whatever its engine.
+ *
+ *  Composing is the costly part, so a monitored machine can be saved in the
+ *  binary format of dfa_file.h, with its error states as the file's error
+ *  states, and loaded again by a later run (see monitor_load).
+ */
+
+#ifndef __VERIF_MONITOR_H__
+#define __VERIF_MONITOR_H__
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "DFA.h"
+#include "Property.h"
+#include "bitset_check.h"
+#include "check_workspace.h"
+#include "dfa_file.h"
+
+/* Symbols on which a human model and a monitored machine move together */
+typedef struct monitor_alignment {
+    std::vector<int> symbols;           /* Interned ID of each symbol */
+    std::vector<int> human_symbols;     /* Human index of each symbol, or DFA_INVALID_SYMBOL */
+    std::vector<int> monitor_symbols;   /* Monitored index of each symbol, or DFA_INVALID_SYMBOL */
+} monitor_alignment_t;
+
+class monitored_machine {
+private:
+    std::vector<bool> machine_symbol;   /* Whether each product symbol is the machine's */
+    std::unique_ptr<bitset_checker> bitset; /* Masks of the product, if checks use the
+                                         * bitset engine */
+    mutable std::mutex alignment_lock;  /* Guards the cached alignment */
+    mutable std::shared_ptr<const dfa_alphabet> aligned_alphabet; /* Human alphabet of
+                                         * the cached alignment, or nullptr */
+    mutable std::shared_ptr<const monitor_alignment_t> alignment; /* Alignment of the
+                                         * human alphabet checked last */
+
+    /* Returns the alignment of a human model, only aligning a new human alphabet */
+    std::shared_ptr<const monitor_alignment_t> cached_align(const dfa& human) const;
+public:
+    std::unique_ptr<dfa> product;       /* Reachable composition of machine and property;
+                * component_states holds the (machine, property) state of each state */
+    std::vector<bool> error;            /* Whether each product state is an error state */
+
+    /** @brief Composes a machine with a property
+     *
+     * @param p Property to monitor
+     * @param machine DFA representing the machine
+     * @param engine Engine that checks without a counterexample run on
+     */
+    monitored_machine(Property& p, dfa& machine, check_engine_t engine = check_engine::BFS);
+
+    /** @brief Wraps a composition that was already built, e.g. one loaded from a file
+     *
+     * @param product Composition of the machine and a property, with component_states
+     *      filled in; the monitored machine takes ownership of it
+     * @param error_states Error states of the composition
+     * @param machine DFA representing the machine
+     * @param engine Engine that checks without a counterexample run on
+     */
+    monitored_machine(dfa *product, const std::set<int>& error_states, const dfa& machine,
+            check_engine_t engine = check_engine::BFS);
+
+    /** @brief Saves the composition to a binary DFA file (see dfa_file.h)
+     *
+     * @param path Path to the file, which is replaced if it exists
+     * @return DFAFILE_NO_ERROR on success, negative error code on failure
+     */
+    int save(const char *path) const;
+
+    /** @brief Aligns a human model against the monitored machine
+     *
+     * Lists every symbol that can fire in the composition of the human and the
+     * monitored machine, with its index in each.  Building the union alphabet looks up
+     * symbol names, so this should be computed once per human alphabet.
+     *
+     * @param human Human model
+     * @return Alignment of the human's alphabet with the product's
+     */
+    monitor_alignment_t align(const dfa& human) const;
+
+    /** @brief Returns how far each monitored state is from the error states
+     *
+     * Steps are taken on the machine's symbols whatever a human model allows, so
+     * each distance is a lower bound for the composition with any human model.
+     *
+     * @return Fewest steps from each product state to an error state, or -1 if no
+     *      error state can be reached from it
+     */
+    std::vector<int> error_distances() const;
+
+    /** @brief Checks if the composition of a human model and the machine satisfies the property
+     *
+     * Same result as p.property_check(human, machine) for the property and machine
+     * this monitored machine was built from.  If a trace is requested, the shortest
+     * violating trace is stored on a violation; trace->states holds the states of the
+     * human, the machine and the property.  Checks that record a trace are always
+     * breadth-first, whatever the engine.
+     *
+     * The alignment of the human's alphabet is kept, so checks of human models that
+     * share an alphabet, such as the modifications of one model, only align it once.
+     *
+     * @param human Human model
+     * @param workspace Storage for the visited set and frontier
+     * @param trace Where to store a counterexample on a violation, or nullptr
+     * @return True if the property is satisfied, false if not
+     */
+    bool check(dfa& human, check_workspace& workspace, counterexample_t *trace = nullptr) const;
+
+    /** @brief Checks if the composition of a human model and the machine satisfies the
+     *      property, given the alignment of the human's alphabet
+     *
+     * As check() above, without looking up the alignment.
+     *
+     * @param human Human model
+     * @param alignment Alignment of the human's alphabet, from align()
+     * @param workspace Storage for the visited set and frontier
+     * @param trace Where to store a counterexample on a violation, or nullptr
+     * @return True if the property is satisfied, false if not
+     */
+    bool check(dfa& human, const monitor_alignment_t& alignment, check_workspace& workspace,
+            counterexample_t *trace = nullptr) const;
+};
+
+/** @brief Loads a monitored machine saved by monitored_machine::save
+ *
+ * The file holds no record of what was composed, so it is checked against the
+ * machine and property given: every state must be reachable, and every transition
+ * and error state must be those that composing them would give.  The states of
+ * the machine and the property that make up each state are recovered on the way.
+ *
+ * @param path Path to the file
+ * @param p Property the machine was composed with
+ * @param machine DFA representing the machine
+ * @param engine Engine that checks without a counterexample run on
+ * @return Pointer to the new monitored machine, or nullptr if the file cannot be read
+ *      or is not the composition of the machine and the property
+ */
+monitored_machine *monitor_load(const char *path, Property& p, dfa& machine,
+        check_engine_t engine = check_engine::BFS);
+
+#endif /* __VERIF_MONITOR_H__ */
@@ -0,0 +1,119 @@
+/** @file mutant.h
+ *  @brief Header for copy-on-write views of modified DFAs
+ *  @author Brian Wei
+ *
+ *  A modification rewrites the rows of only the few states of one pattern
+ *  instance (see dfa::DFA_modify).  A mutant view records just those rows as an
+ *  overlay on a shared, unmodified base DFA.  It is read through the same apply()
+ *  interface as a dfa, so making a mutant costs O(edits) rather than a copy of
+ *  the whole transition matrix.
+ *
+ *  Rows are copied from the base the first time one of their transitions is
+ *  edited.  Final states are never modified, so they are always the base's.  A
+ *  full dfa is only built when one is needed, by writing the overlay into a copy
+ *  of the base.
+ */
+
+#ifndef __VERIF_MUTANT_H__
+#define __VERIF_MUTANT_H__
+
+#include <vector>
+#include "DFA.h"
+
+class dfa_mutant {
+private:
+    const dfa *base;                /* Unmodified DFA shared by every mutant */
+    std::vector<int> touched;       /* States with an overlaid row, in order of first edit */
+    std::vector<int> rows;          /* Overlaid row of each touched state, in the same order */
+
+    /** @brief Returns the overlaid row of a state, copying it from the base if needed
+     *
+     * @param state State whose row will be edited
+     * @return Row of the state, alphabet_size entries
+     */
+    int *edit_row(int state);
+public:
+    /** @brief Constructs an unmodified view of a base DFA
+     *
+     * @note The base must outlive the view and must not change while it is used
+     *
+     * @param base DFA that the mutant is made from
+     */
+    explicit dfa_mutant(const dfa& base);
+
+    /** @brief Returns the DFA that the mutant is made from
+     *
+     * @return Base DFA
+     */
+    const dfa& get_base() const { return *this->base; }
+
+    /** @brief Returns the states whose rows may differ from the base
+     *
+     * @return Touched states, in order of first edit
+     */
+    const std::vector<int>& touched_states() const { return this->touched; }
+
+    /** @brief Drops every edit, so the view matches the base again
+     */
+    void clear();
+
+    /** @brief Returns the row of transitions from a state
+     *
+     * @param state State of the base DFA
+     * @return Row of the state, alphabet_size entries
+     */
+    const int *row(int state) const {
+        for (size_t i = 0; i < this->touched.size(); i++) {
+            if (this->touched[i] == state) return &this->rows[(size_t) i * this->base->alphabet_size];
+        }
+        return &this->base->transition_matrix[(size_t) state * this->base->alphabet_size];
+    }
+
+    /** @brief Returns the next state of the mutant, as dfa::apply()
+     *
+     * @param state Current state
+     * @param symbol_index Index of the symbol in the base's alphabet
+     * @return Next state, or DFA_DUMMY_SYMBOL if the transition is undefined
+     */
+    int apply(int state, int symbol_index) const {
+        return this->row(state)[symbol_index];
+    }
+
+    /** @brief Sets one transition of the mutant
+     *
+     * @param state Source state
+     * @param symbol_index Index of the symbol in the base's alphabet
+     * @param target Target state, or DFA_DUMMY_SYMBOL
+     */
+    void set(int state, int symbol_index, int target);
+
+    /** @brief Modifies one instance of a pattern into another, as dfa::DFA_modify()
+     *
+     * @param original_pattern Pattern which was found in the base
+     * @param target_pattern Pattern to rewrite the instance into, with the same number
+     *      of states and symbols
+     * @param pattern Instance of the original pattern in the base
+     * @return 0 on success or a negative DFA error code
+     */
+    int modify(dfa& original_pattern, dfa& target_pattern, const pattern_output& pattern);
+
+    /** @brief Writes the edits into a DFA holding the base's rows for the touched states
+     *
+     * @param M Copy of the base, or one written to by another mutant and reverted since
+     */
+    void write(dfa& M) const;
+
+    /** @brief Restores the base's rows for the touched states of a DFA
+     *
+     * @param M DFA that this mutant was written into
+     */
+    void revert(dfa& M) const;
+
+    /** @brief Builds the mutant as a full DFA
+     *
+     * @return Newly allocated copy of the base with the edits applied
+     */
+    dfa *to_dfa() const;
+};
+
+#endif /* __VERIF_MUTANT_H__ */
@@ -9,17 +9,26 @@
 #ifndef __VERIF_PATTERN_LIB_H__
 #define __VERIF_PATTERN_LIB_H__
 
+#include <memory>
+#include <vector>
 #include "modify.h"
 
+/* Pattern library; it owns its patterns and maps, which are freed with it */
+typedef struct pattern_library {
+    mapping_list mappings;          /* Maps of the library, in order */
+    std::vector<std::unique_ptr<dfa>> patterns;         /* Patterns that the maps use */
+    std::vector<std::unique_ptr<pattern_map_t>> maps;   /* Maps listed in mappings */
+} pattern_library_t;
+
 /** @brief Initializes the pattern library
  *
  * Current implementation of the pattern library includes premature start, delayed
  * start, omission, reversal, intrusion, and repetition
  *
- * @param mappings Reference to mapping_list to put the pattens in
- * @return zero on success, negative error code on failure
+ * @param library Library to put the patterns in, whose mappings can be passed to
+ *      modify_violate_property while it is alive
  */
-void patternlib_init(mapping_list &mappings);
+void patternlib_init(pattern_library_t &library);
 
 #endif /* __VERIF_PATTERN_LIB_H__ */
 
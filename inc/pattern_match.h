@@ -0,0 +1,139 @@
+/** @file pattern_match.h
+ *  @brief Header for the pattern matching engine
+ *  @author Brian Wei
+ *
+ *  Finds instances of a pattern DFA inside a larger DFA.  An instance is an
+ *  injective assignment of host states to pattern states and of host symbols to
+ *  pattern symbols such that every transition defined in the pattern is present
+ *  between the assigned host states on the assigned host symbol.
+ *
+ *  The search is a VF2-style backtracking search.  Pattern states are assigned
+ *  one at a time, and each pattern symbol keeps the set of host symbols still
+ *  consistent with every pattern transition whose endpoints are both assigned.
+ *  A partial assignment is abandoned as soon as any of those sets becomes empty.
+ *  Host states are pre-filtered by out-degree, and a pattern state that is the
+ *  target of a transition from an already assigned state only considers the host
+ *  successors on the candidate symbols.  Instances are produced in the same order
+ *  as a brute-force enumeration: state tuples in lexicographic order, then symbol
+ *  tuples in lexicographic order.
+ */
+
+#ifndef __VERIF_PATTERN_MATCH_H__
+#define __VERIF_PATTERN_MATCH_H__
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "DFA.h"
+
+class pattern_matcher {
+private:
+    const dfa& host;            /* DFA being searched */
+    const dfa& pattern;         /* Pattern being searched for */
+    int num_words;              /* Words per host symbol set */
+    std::vector<int> pattern_degree;    /* Defined transitions of each pattern state */
+    std::vector<int> host_degree;       /* Defined transitions of each host state */
+    std::vector<std::vector<int>> closing_edges;  /* For each pattern state q, the
+                * pattern transitions (as state * |alphabet| + symbol) whose
+                * endpoints are both assigned once q is */
+    std::vector<std::vector<int>> opening_edges;  /* For each pattern state q, the
+                * pattern transitions out of q to a later state */
+    std::vector<int> entry_edge;        /* For each pattern state q, a transition into q
+                * from an earlier state, or -1 */
+
+    std::vector<uint64_t> candidates;   /* Host symbol sets per search level; level l
+                * holds one set per pattern symbol after assigning l states */
+    std::vector<std::vector<int>> state_candidates; /* Host states to try per level */
+    std::vector<int> state_cursor;      /* Next candidate to try per level */
+    std::vector<int> states;            /* Host state assigned to each pattern state */
+    std::vector<char> state_used;       /* Whether each host state is assigned */
+    std::vector<int> symbols;           /* Host symbol assigned to each pattern symbol */
+    std::vector<char> symbol_used;      /* Whether each host symbol is assigned */
+    int level;                          /* Number of pattern states assigned */
+    int symbol_level;                   /* Number of pattern symbols assigned */
+    bool started;                       /* Whether the search has begun */
+    bool finished;                      /* Whether the search is exhausted */
+
+    /* Returns the symbol set of a pattern symbol at a search level */
+    uint64_t *symbol_set(int level, int symbol) {
+        return &this->candidates[((size_t) level * this->pattern.alphabet_size + symbol) * this->num_words];
+    }
+
+    /* Fills the host states to try for the current level */
+    void collect_state_candidates();
+
+    /* Tries to assign a host state to the current level, narrowing the symbol sets */
+    bool assign_state(int host_state);
+
+    /* Advances the state search to the next full state assignment */
+    bool next_state_assignment();
+
+    /* Advances the symbol search to the next full symbol assignment */
+    bool next_symbol_assignment();
+public:
+    /** @brief Prepares a search for a pattern within a DFA
+     *
+     * @note Both DFAs must outlive the matcher and must not change during the search
+     *
+     * @param host DFA to search in
+     * @param pattern Pattern to search for
+     */
+    pattern_matcher(const dfa& host, const dfa& pattern);
+
+    /** @brief Finds the next instance of the pattern
+     *
+     * @param output Where to store the instance, as host states and interned symbol IDs
+     * @return True if an instance was found, false if there are no more
+     */
+    bool next(pattern_output& output);
+};
+
+/* Cache of pattern instances, shared between all searches for structurally equal
+ * patterns in structurally equal DFAs.  Instances are found lazily: each entry
+ * keeps its matcher and only searches as far as the furthest instance asked for. */
+class match_cache {
+private:
+    typedef struct entry {
+        const dfa *host;        /* DFA searched by the entry */
+        const dfa *pattern;     /* Pattern searched for by the entry */
+        std::unique_ptr<pattern_matcher> matcher;   /* Search, until exhausted */
+        std::vector<pattern_output> instances;      /* Instances found so far */
+        std::mutex lock;        /* Guards the matcher and the instances */
+    } entry_t;
+
+    std::vector<std::unique_ptr<entry_t>> entries;  /* Entries by ID */
+    std::unordered_multimap<uint64_t, int> index;   /* Entry IDs by combined hash */
+    const dfa *hashed_host;     /* Host of the last lookup, or nullptr */
+    uint64_t host_hash;         /* Hash of hashed_host, computed once */
+public:
+    /** @brief Constructs an empty cache
+     */
+    match_cache();
+
+    /** @brief Finds the entry for a search, creating it if there is none
+     *
+     * @note The DFAs of a new entry must outlive the cache and must not change.
+     *          Lookups in a row with the same host hash it only once
+     *
+     * @param host DFA to search in
+     * @param pattern Pattern to search for
+     * @return ID of the entry, equal for structurally equal (host, pattern) pairs
+     */
+    int lookup(const dfa& host, const dfa& pattern);
+
+    /** @brief Fetches an instance of an entry's pattern
+     *
+     * @note Safe to call from several threads at once, as long as no lookup runs
+     *          meanwhile; searches of different entries run in parallel
+     *
+     * @param entry_id ID of the entry, from lookup
+     * @param instance_no Index of the instance, in matcher order
+     * @param output Where to store the instance
+     * @return True if the instance exists, false if there are fewer instances
+     */
+    bool instance(int entry_id, int instance_no, pattern_output& output);
+};
+
+#endif /* __VERIF_PATTERN_MATCH_H__ */
@@ -0,0 +1,84 @@
+/** @file property_set.h
+ *  @brief Header for sets of properties checked together
+ *  @author Brian Wei
+ *
+ *  A property set checks any number of properties against the same composition
+ *  without composing it once per property.  The reachable part of the composition
+ *  is explored a single time, into an explicit graph of its states and
+ *  transitions.  Every property is then run over that graph, with no further
+ *  work on the components.
+ *
+ *  Each property's search is breadth-first over (graph state, property state)
+ *  pairs, and stops at its first error.  Its visited set is a bitmap of one bit
+ *  per pair, which stays small enough to remain in cache.  Advancing all the
+ *  properties in lockstep instead would need a row per property at every graph
+ *  state.  A violated property's search is repeated with tracing to build its
+ *  witness.  The witness is a shortest violating trace, the same length as one
+ *  found by Property::property_check.
+ *
+ *  Pairs whose property state can no longer reach an error are not expanded.  A
+ *  property that no composition can violate is satisfied without a search, and if
+ *  that holds for every property the composition is not explored at all.
+ */
+
+#ifndef __VERIF_PROPERTY_SET_H__
+#define __VERIF_PROPERTY_SET_H__
+
+#include <vector>
+#include "DFA.h"
+#include "Property.h"
+
+/* Outcome of checking a property set */
+typedef struct property_set_result {
+    std::vector<bool> satisfied;            /* Whether each property is satisfied */
+    std::vector<counterexample_t> witnesses;    /* Shortest violating trace of each
+                                 * violated property, empty for satisfied ones;
+                                 * states hold the components, then the property */
+} property_set_result_t;
+
+class PropertySet {
+private:
+    std::vector<Property*> properties;  /* Properties in the order they were added */
+
+    /** @brief Checks every property against the composition of some components
+     *
+     * @param components DFAs composed together, one or two
+     * @param result Where to store the outcome
+     */
+    void check_components(const std::vector<const dfa*> &components,
+            property_set_result_t &result) const;
+public:
+    /** @brief Adds a property to the set
+     *
+     * @param p Property to add, which must outlive the set
+     */
+    void add(Property &p);
+
+    /** @brief Returns the number of properties in the set
+     *
+     * @return Number of properties
+     */
+    int size() const { return this->properties.size(); }
+
+    /** @brief Checks every property against a DFA in one exploration
+     *
+     * Same verdicts as p.property_check(M) for each property p of the set.
+     *
+     * @param M State machine to check the properties on
+     * @return Verdict and witness of each property, in the order they were added
+     */
+    property_set_result_t check(dfa &M) const;
+
+    /** @brief Checks every property against the parallel composition of two DFAs
+     *      in one exploration
+     *
+     * Same verdicts as p.property_check(M1, M2) for each property p of the set.
+     *
+     * @param M1 First component, typically the human model
+     * @param M2 Second component, typically the machine
+     * @return Verdict and witness of each property, in the order they were added
+     */
+    property_set_result_t check(dfa &M1, dfa &M2) const;
+};
+
+#endif /* __VERIF_PROPERTY_SET_H__ */
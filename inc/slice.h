@@ -0,0 +1,94 @@
+/** @file slice.h
+ *  @brief Header for alphabet slicing of compositions
+ *  @author Brian Wei
+ *
+ *  Whether the composition of two DFAs violates a property depends only on the
+ *  symbols the property observes, and on the symbols the two DFAs synchronize on.
+ *  Any other symbol is a local action of one DFA.  It moves neither the other DFA
+ *  nor the property, so it can be hidden without changing the verdict.
+ *
+ *  Slicing hides those local actions inside one DFA before composition.  The
+ *  result moves only on relevant symbols.  Each of its states is the set of
+ *  original states reachable by hidden actions from where a relevant trace leads.
+ *  States joined by hidden actions in both directions therefore collapse into one.
+ *  The traces of the result are exactly the relevant parts of the original's
+ *  traces.  A counterexample found on it is mapped back with slice_expand(), which
+ *  puts the hidden actions back in.
+ */
+
+#ifndef __VERIF_SLICE_H__
+#define __VERIF_SLICE_H__
+
+#include <vector>
+#include "DFA.h"
+#include "Property.h"
+
+/** @brief Finds the symbols that can influence whether a composition violates a property
+ *
+ * These are the symbols of the property, and the symbols both DFAs have.
+ *
+ * @param M1 First DFA of the composition
+ * @param M2 Second DFA of the composition
+ * @param p Property that the composition is checked against
+ * @return Interned IDs of the relevant symbols, in increasing order
+ */
+std::vector<int> slice_relevant(const dfa &M1, const dfa &M2, const Property &p);
+
+/** @brief Hides every symbol of a DFA that is not relevant
+ *
+ * The result is built by subset construction over the relevant symbols.  Each
+ * subset is closed under the hidden symbols.  A state is final if any state
+ * merged into it is final.
+ *
+ * @param M DFA to slice
+ * @param relevant Interned IDs of the symbols to keep, in increasing order, such as
+ *      from slice_relevant()
+ * @param mapping Where to store the original states merged into each state of the
+ *      result, in increasing order; may be nullptr
+ * @return Pointer to the new DFA, whose alphabet is M's relevant symbols in M's order
+ */
+dfa *slice_hide(const dfa &M, const std::vector<int> &relevant,
+        std::vector<std::vector<int>> *mapping);
+
+/** @brief Maps a counterexample found on sliced DFAs back to the original DFAs
+ *
+ * Searches breadth-first for the shortest trace of the composition of M1 and M2 that
+ * takes the symbols of the counterexample in order, with hidden symbols in between,
+ * then replaces the counterexample with it.  The property is driven by relevant
+ * symbols only, so the new trace reaches the same property states.  Either DFA may
+ * be the one that was sliced, or both.
+ *
+ * @param trace Counterexample found on the sliced DFAs, whose states hold the
+ *      components M1, M2 and the property; updated in place
+ * @param M1 First DFA of the composition, as given before slicing
+ * @param M2 Second DFA of the composition, as given before slicing
+ * @param p Property the counterexample violates
+ * @param relevant Interned IDs of the symbols that were kept, in increasing order
+ * @return True if the counterexample was mapped back, false if the original DFAs
+ *      cannot perform its symbols
+ */
+bool slice_expand(counterexample_t *trace, const dfa &M1, const dfa &M2, const Property &p,
+        const std::vector<int> &relevant);
+
+/** @brief Maps a counterexample found on sliced DFAs back to the original DFAs, or
+ *      finds one on the original DFAs if it cannot be mapped back
+ *
+ * Tries slice_expand() first.  If that fails, the composition of M1 and M2 is
+ * searched again with p.property_check(), so the counterexample never mixes states
+ * of sliced and original DFAs.
+ *
+ * @param trace Counterexample found on the sliced DFAs, whose states hold the
+ *      components M1, M2 and the property; replaced by one of the original DFAs,
+ *      or cleared if there is none
+ * @param M1 First DFA of the composition, as given before slicing
+ * @param M2 Second DFA of the composition, as given before slicing
+ * @param p Property the counterexample violates
+ * @param relevant Interned IDs of the symbols that were kept, in increasing order
+ * @param workspace Storage for the search on the original DFAs
+ * @return True if trace holds a counterexample of the original DFAs, false if their
+ *      composition satisfies the property
+ */
+bool slice_restore(counterexample_t *trace, dfa &M1, dfa &M2, Property &p,
+        const std::vector<int> &relevant, check_workspace &workspace);
+
+#endif /* __VERIF_SLICE_H__ */
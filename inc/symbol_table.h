@@ -0,0 +1,46 @@
+/** @file symbol_table.h
+ *  @brief Header for the global symbol table
+ *  @author Brian Wei
+ *
+ *  Every transition name used by a DFA, property or pattern is interned here
+ *  exactly once and afterwards referred to by a small dense integer ID.  This
+ *  lets alphabets be stored and compared as integer vectors, and lets two
+ *  alphabets be aligned without any string comparisons.  The table only ever
+ *  grows, so IDs and names stay valid for the life of the program.
+ */
+
+#ifndef __VERIF_SYMBOL_TABLE_H__
+#define __VERIF_SYMBOL_TABLE_H__
+
+#include <string>
+
+#define SYMBOL_NOT_FOUND    (-1)
+
+/** @brief Interns a symbol, adding it to the table if not yet present
+ *
+ * @param name Name of the symbol
+ * @return ID of the symbol
+ */
+int symbol_intern(const std::string& name);
+
+/** @brief Looks up the ID of a symbol without adding it
+ *
+ * @param name Name of the symbol
+ * @return ID of the symbol, or SYMBOL_NOT_FOUND if it was never interned
+ */
+int symbol_find(const std::string& name);
+
+/** @brief Returns the name of an interned symbol
+ *
+ * @param id ID of the symbol, must have been returned by symbol_intern
+ * @return Name of the symbol
+ */
+const std::string& symbol_name(int id);
+
+/** @brief Returns the number of symbols interned so far
+ *
+ * @return Number of symbols, all IDs are below this value
+ */
+int symbol_count();
+
+#endif /* __VERIF_SYMBOL_TABLE_H__ */
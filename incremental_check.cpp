@@ -0,0 +1,150 @@
+/** @file incremental_check.cpp
+ *  @brief Incremental property checking of modified DFAs
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include "inc/incremental_check.h"
+
+/* *****     IMPLEMENTATION     ***** */
+
+incremental_checker::incremental_checker(const monitored_machine& monitor, dfa& base)
+        : monitor(monitor) {
+    const dfa& monitor_dfa = *monitor.product;
+    this->base_num_states = base.num_states;
+    this->base_alphabet = base.alphabet;
+    this->alignment = monitor.align(base);
+    int num_symbols = this->alignment.human_symbols.size();
+
+    /* Breadth-first exploration of the base product, as in monitored_machine::check,
+     * which numbers states in discovery order and records every edge */
+    uint64_t num_monitor_states = monitor_dfa.num_states;
+    std::unordered_map<uint64_t, int> ids;
+    std::vector<std::pair<int, int>> edges; /* (source, target) */
+    auto discover = [&](int h, int m, int from) {
+        uint64_t key = h * num_monitor_states + m;
+        auto inserted = ids.insert({key, (int) this->keys.size()});
+        if (inserted.second) {
+            this->keys.push_back(key);
+            this->base_state.push_back(h);
+            this->parent.push_back(from);
+        }
+        return inserted.first->second;
+    };
+    discover(base.initial_state, monitor_dfa.initial_state, -1);
+
+    this->base_satisfied = true;
+    for (int current = 0; current < this->keys.size() && this->base_satisfied; current++) {
+        int h = this->base_state[current];
+        int m = this->keys[current] % num_monitor_states;
+        for (int k = 0; k < num_symbols; k++) {
+            int h_symbol = this->alignment.human_symbols[k];
+            int m_symbol = this->alignment.monitor_symbols[k];
+            int h_target = h_symbol < 0 ? h : base.apply(h, h_symbol);
+            int m_target = m_symbol < 0 ? m : monitor_dfa.apply(m, m_symbol);
+            if (h_target == DFA_DUMMY_SYMBOL || m_target == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+            if (monitor.error[m_target]) {
+                this->base_satisfied = false;
+                break;
+            }
+            edges.emplace_back(current, discover(h_target, m_target, current));
+        }
+    }
+
+    if (!this->base_satisfied) {
+        /* Every mutant will be checked in full, so nothing needs to be kept */
+        this->keys.clear();
+        this->base_state.clear();
+        this->parent.clear();
+        return;
+    }
+
+    /* Group the predecessors of every state together */
+    int num_states = this->keys.size();
+    this->pred_start.assign(num_states + 1, 0);
+    for (auto& edge : edges) this->pred_start[edge.second + 1]++;
+    for (int i = 0; i < num_states; i++) this->pred_start[i + 1] += this->pred_start[i];
+    this->preds.resize(edges.size());
+    auto fill = std::vector<int>(this->pred_start.begin(), this->pred_start.end() - 1);
+    for (auto& edge : edges) this->preds[fill[edge.second]++] = edge.first;
+}
+
+bool incremental_checker::check(const dfa_mutant& mutant, check_workspace& workspace) const {
+    assert(mutant.get_base().num_states == this->base_num_states);
+    assert(mutant.get_base().alphabet->symbols == this->base_alphabet->symbols);
+
+    const dfa& monitor_dfa = *this->monitor.product;
+    int num_symbols = this->alignment.human_symbols.size();
+    uint64_t num_monitor_states = monitor_dfa.num_states;
+    int num_states = this->keys.size();
+    workspace.reset((uint64_t) this->base_num_states * num_monitor_states);
+
+    if (!this->base_satisfied) {
+        /* Nothing of the base was kept, so the mutant's product is explored in full */
+        uint64_t first = mutant.get_base().initial_state * num_monitor_states + monitor_dfa.initial_state;
+        workspace.visit(first);
+        workspace.push(first);
+    } else {
+        char *touched = workspace.allocate<char>(this->base_num_states);
+        std::fill_n(touched, this->base_num_states, 0);
+        for (int s : mutant.touched_states()) touched[s] = 1;
+
+        /* A state stays reachable if no state on its tree path before it was touched */
+        char *valid = workspace.allocate<char>(num_states);
+        valid[0] = 1;
+        for (int i = 1; i < num_states; i++) {
+            int from = this->parent[i];
+            valid[i] = valid[from] && !touched[this->base_state[from]];
+        }
+
+        for (int i = 0; i < num_states; i++) {
+            if (!valid[i]) continue;
+            workspace.visit(this->keys[i]);
+            if (touched[this->base_state[i]]) workspace.push(this->keys[i]);
+        }
+
+        /* Other base states are reachable if an unchanged edge leads to them from a
+         * state which is; those get explored like any newly found state */
+        for (int i = 0; i < num_states; i++) {
+            if (valid[i]) continue;
+            for (int k = this->pred_start[i]; k < this->pred_start[i + 1]; k++) {
+                int from = this->preds[k];
+                if (valid[from] && !touched[this->base_state[from]]) {
+                    workspace.visit(this->keys[i]);
+                    workspace.push(this->keys[i]);
+                    break;
+                }
+            }
+        }
+    }
+
+    while (!workspace.empty()) {
+        uint64_t current = workspace.pop();
+        int h = current / num_monitor_states;
+        int m = current % num_monitor_states;
+        const int *row = mutant.row(h);
+        for (int k = 0; k < num_symbols; k++) {
+            int h_symbol = this->alignment.human_symbols[k];
+            int m_symbol = this->alignment.monitor_symbols[k];
+            int h_target = h_symbol < 0 ? h : row[h_symbol];
+            int m_target = m_symbol < 0 ? m : monitor_dfa.apply(m, m_symbol);
+            if (h_target == DFA_DUMMY_SYMBOL || m_target == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+            if (this->monitor.error[m_target]) {
+                return false;
+            }
+            uint64_t next = h_target * num_monitor_states + m_target;
+            if (workspace.visit(next)) {
+                workspace.push(next);
+            }
+        }
+    }
+    return true;
+}
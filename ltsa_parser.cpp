@@ -5,128 +5,270 @@
  *  See header file for detailed documentation
  */
 
-#include <fstream>
-#include <iostream>
+#include <cctype>
 #include <cstdio>
-#include <map>
+#include <cstring>
 #include <string>
-#include <cctype>
-#include <algorithm>
-#include <boost/algorithm/string/trim.hpp>
-#include <boost/algorithm/string/split.hpp>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "inc/ltsa_parser.h"
 
-/* strip whitespace string */
-#define STRIP(str) ((str).erase(std::remove_if((str).begin(), (str).end(), ::isspace), (str).end()));
+/* Transition as read from the file, before the transition table is built */
+typedef struct parser_edge {
+    int state;                  /* Source state */
+    int symbol;                 /* Alphabet index of the symbol */
+    int target;                 /* Target state, or DFA_DUMMY_SYMBOL for ERROR */
+} parser_edge_t;
+
+/* Contents of an input file, mapped into memory when possible */
+typedef struct parser_input {
+    const char *data;           /* First byte of the file */
+    size_t size;                /* Number of bytes in the file */
+    void *mapping;              /* Memory mapping of the file, or nullptr if read */
+    std::vector<char> buffer;   /* Contents of the file if it could not be mapped */
+} parser_input_t;
+
+/* Symbols of a model in order of first appearance */
+typedef struct parser_symbols {
+    std::vector<std::string> names;             /* Name of each alphabet index */
+    std::unordered_map<std::string, int> ids;   /* Alphabet index of each name */
+    std::string scratch;        /* Reused buffer for the name being looked up */
+} parser_symbols_t;
 
-/** @brief Ignore some lines from a file
+/** @brief Maps a file into memory, or reads it if it cannot be mapped
  *
- * @param line Probably not needed...
- * @param f File stream to ignore from
- * @param count Number of lines to ignore
+ * @param path Path to the file
+ * @param input Where to store the contents
+ * @return Zero on success, -1 if the file cannot be opened
  */
-static void ignore_lines(std::string &line, std::ifstream &f, int count);
+static int parser_open(const char *path, parser_input_t &input);
 
-/* ***** IMPLEMENTATIONN ***** */
+/** @brief Releases the contents of a file
+ *
+ * @param input Contents from parser_open
+ */
+static void parser_close(parser_input_t &input);
 
-static void ignore_lines(std::string &line, std::ifstream &f, int count) {
-    for (int i = 0; i < count; i++) {
-        std::getline(f, line);
-    }
-}
+/** @brief Finds the end of the line starting at pos
+ *
+ * @param pos Start of the line
+ * @param end End of the input
+ * @return Position of the line's newline, or end if there is none
+ */
+static const char *line_end(const char *pos, const char *end);
+
+/** @brief Finds the start of the line after the one starting at pos
+ *
+ * @param pos Start of the line
+ * @param end End of the input
+ * @return Start of the next line, or end if there is none
+ */
+static const char *next_line(const char *pos, const char *end);
+
+/** @brief Looks up a symbol name, ignoring all whitespace in it, adding it if new
+ *
+ * @param begin First character of the name
+ * @param end One past the last character of the name
+ * @param symbols Symbols seen so far
+ * @return Alphabet index of the symbol
+ */
+static int parser_symbol(const char *begin, const char *end, parser_symbols_t &symbols);
+
+/** @brief Finds the first occurrence of a string within a range
+ *
+ * @param begin Start of the range
+ * @param end End of the range
+ * @param needle Null terminated string to look for
+ * @return Position of the occurrence, or nullptr if there is none
+ */
+static const char *find_in(const char *begin, const char *end, const char *needle);
+
+/* *****     IMPLEMENTATION     ***** */
 
 dfa *parser_go(const char *path) {
+    parser_input_t input;
+    if (parser_open(path, input) < 0) {
+        fprintf(stderr, "Could not open LTSA output %s\n", path);
+        return nullptr;
+    }
+    const char *pos = input.data;
+    const char *end = input.data + input.size;
 
-    std::string line;
-    std::ifstream f(path);
-    ignore_lines(line, f, 3);
-    int num_states;
-    f >> num_states;
-    ignore_lines(line, f, 3);
+    /* Header: process name, state count, and the line naming the initial state */
+    for (int i = 0; i < 3; i++) pos = next_line(pos, end);
+    while (pos < end && isspace(*pos)) pos++;
+    int num_states = 0;
+    while (pos < end && isdigit(*pos)) num_states = num_states * 10 + (*pos++ - '0');
+    for (int i = 0; i < 3; i++) pos = next_line(pos, end);
+
+    /* Single pass over the transitions into a flat edge list; each state is
+     * listed in order and its last line ends in ',' (or '.' for the last state) */
+    std::vector<parser_edge_t> edges;
+    std::vector<char> sinks(num_states, 0);
+    parser_symbols_t symbols;
     int current_state_number = 0;
-    int current_transition_counter = 0;
-
-    std::map<std::string, int> transition_numbers;
-    std::map<std::string, int>::iterator it;
-
-    std::map<int, int> transitions[num_states];
-    std::vector<int> sinks;
-    auto *symbols = new std::vector<std::string>();
-    while (std::getline(f, line)) {
-        int ind_of_arrow = line.find("->", 0);
-        int start_of_trans_name;
-        if ((start_of_trans_name = line.find('(', 0)) != std::string::npos) {
-            start_of_trans_name++;
-        } else if ((start_of_trans_name = line.find('|', 0)) != std::string::npos) {
-            start_of_trans_name++;
-        } else {
-            assert(line.find("STOP", 0) != std::string::npos);
-            sinks.push_back(current_state_number++);
+    bool malformed = false;
+    for (; pos < end; pos = next_line(pos, end)) {
+        const char *line = pos;
+        const char *eol = line_end(pos, end);
+        while (eol > line && isspace(eol[-1])) eol--;
+        if (eol == line) continue;
+        if (current_state_number >= num_states) {
+            malformed = true;
+            break;
+        }
+
+        const char *name = (const char *) memchr(line, '(', eol - line);
+        if (name == nullptr) name = (const char *) memchr(line, '|', eol - line);
+        if (name == nullptr) {
+            if (find_in(line, eol, "STOP") == nullptr) {
+                malformed = true;
+                break;
+            }
+            sinks[current_state_number++] = 1;
             continue;
         }
-        const char *ending = line.substr(1 + line.find_last_of('Q', std::string::npos)).c_str();
-        int target_state;
-        sscanf(ending, "%d", &target_state);
-
-        std::pair<int, int> curly_inds;
-        curly_inds.first = line.find('{', 0);
-        curly_inds.second = line.find('}', 0);
-        if (curly_inds.first != std::string::npos && curly_inds.second != std::string::npos) {
-            std::string between_curly = line.substr(curly_inds.first + 1, curly_inds.second - curly_inds.first - 1);
-            std::vector<std::string> tokens;
-            boost::split(tokens, between_curly, boost::is_any_of(","));
-            for (auto& t : tokens) {
-                STRIP(t);
-                int this_transition_num;
-                if ((it = transition_numbers.find(t)) == transition_numbers.end()) {
-                    transition_numbers.insert(std::pair<std::string, int>(t, current_transition_counter));
-                    this_transition_num = current_transition_counter;
-                    current_transition_counter++;
-                    symbols->push_back(t);
-                } else {
-                    this_transition_num = it->second;
-                }
-                transitions[current_state_number].insert(std::pair<int, int>(this_transition_num, target_state));
+        name++;
+        const char *arrow = find_in(line, eol, "->");
+        if (arrow == nullptr) {
+            malformed = true;
+            break;
+        }
+
+        int target_state = DFA_DUMMY_SYMBOL;
+        if (find_in(arrow, eol, "ERROR") == nullptr) {
+            const char *q = eol;
+            while (q > arrow && q[-1] != 'Q') q--;
+            if (q == arrow) {
+                malformed = true;
+                break;
             }
-        } else {
-            int trans_name_len = ind_of_arrow - start_of_trans_name;
-            std::string trans_name = line.substr(start_of_trans_name, trans_name_len);
-            STRIP(trans_name);
-            int this_transition_num;
-            if ((it = transition_numbers.find(trans_name)) == transition_numbers.end()) {
-                transition_numbers.insert(std::pair<std::string, int>(trans_name, current_transition_counter));
-                this_transition_num = current_transition_counter;
-                current_transition_counter++;
-                symbols->push_back(trans_name);
-            } else {
-                this_transition_num = it->second;
+            target_state = 0;
+            while (q < eol && isdigit(*q)) target_state = target_state * 10 + (*q++ - '0');
+            if (target_state >= num_states) {
+                malformed = true;
+                break;
             }
+        }
 
-            transitions[current_state_number].insert(std::pair<int, int>(this_transition_num, target_state));
+        const char *open_curly = (const char *) memchr(line, '{', eol - line);
+        const char *close_curly = (const char *) memchr(line, '}', eol - line);
+        if (open_curly != nullptr && close_curly != nullptr) {
+            const char *token = open_curly + 1;
+            while (true) {
+                const char *comma = (const char *) memchr(token, ',', close_curly - token);
+                const char *token_end = comma == nullptr ? close_curly : comma;
+                edges.push_back({current_state_number, parser_symbol(token, token_end, symbols),
+                        target_state});
+                if (comma == nullptr) break;
+                token = comma + 1;
+            }
+        } else {
+            edges.push_back({current_state_number, parser_symbol(name, arrow, symbols),
+                    target_state});
         }
-        if (line.at(line.length() - 1) == ',') {
+        if (eol[-1] == ',') {
             current_state_number++;
         }
     }
+    parser_close(input);
+    if (malformed) {
+        fprintf(stderr, "Malformed LTSA output %s\n", path);
+        return nullptr;
+    }
 
+    /* Build the table directly; the first transition listed for a (state, symbol)
+     * pair is kept, and states that STOP loop on every symbol */
     std::vector<bool> finals(num_states, false);
-    int alphabet_size = current_transition_counter;
-    std::vector<int> trans;
-    trans.resize(num_states * alphabet_size);
-
+    int alphabet_size = symbols.names.size();
+    std::vector<int> trans((size_t) num_states * alphabet_size, DFA_DUMMY_SYMBOL);
+    for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+        trans[(size_t) it->state * alphabet_size + it->symbol] = it->target;
+    }
     for (int q = 0; q < num_states; q++) {
-        if (std::find(sinks.begin(), sinks.end(), q) != sinks.end()) {
-            for (int s = 0; s < alphabet_size; s++) {
-                trans[q * alphabet_size + s] = q;
-            }
-            continue;
-        }
+        if (!sinks[q]) continue;
         for (int s = 0; s < alphabet_size; s++) {
-            auto it = transitions[q].find(s);
-            if (it == transitions[q].end()) trans[q * alphabet_size + s] = -1;
-            else trans[q * alphabet_size + s] = it->second;
+            trans[(size_t) q * alphabet_size + s] = q;
         }
     }
     return new dfa(num_states, alphabet_size, 0,
-            finals, *symbols, trans.data());
+            finals, symbols.names, trans.data());
+}
+
+static int parser_open(const char *path, parser_input_t &input) {
+    input.data = nullptr;
+    input.size = 0;
+    input.mapping = nullptr;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+            input.mapping = mapping;
+            input.data = (const char *) mapping;
+            input.size = info.st_size;
+            close(fd);
+            return 0;
+        }
+    }
+
+    /* Not mappable (e.g. a pipe), so read it in chunks instead */
+    char chunk[1 << 16];
+    ssize_t count;
+    while ((count = read(fd, chunk, sizeof(chunk))) > 0) {
+        input.buffer.insert(input.buffer.end(), chunk, chunk + count);
+    }
+    close(fd);
+    input.data = input.buffer.data();
+    input.size = input.buffer.size();
+    return 0;
+}
+
+static void parser_close(parser_input_t &input) {
+    if (input.mapping != nullptr) {
+        munmap(input.mapping, input.size);
+        input.mapping = nullptr;
+    }
+}
+
+static const char *line_end(const char *pos, const char *end) {
+    const char *newline = (const char *) memchr(pos, '\n', end - pos);
+    return newline == nullptr ? end : newline;
+}
+
+static const char *next_line(const char *pos, const char *end) {
+    const char *eol = line_end(pos, end);
+    return eol == end ? end : eol + 1;
+}
+
+static int parser_symbol(const char *begin, const char *end, parser_symbols_t &symbols) {
+    symbols.scratch.clear();
+    for (const char *c = begin; c < end; c++) {
+        if (!isspace(*c)) symbols.scratch.push_back(*c);
+    }
+    auto it = symbols.ids.find(symbols.scratch);
+    if (it != symbols.ids.end()) {
+        return it->second;
+    }
+    int index = symbols.names.size();
+    symbols.names.push_back(symbols.scratch);
+    symbols.ids.insert({symbols.scratch, index});
+    return index;
+}
+
+static const char *find_in(const char *begin, const char *end, const char *needle) {
+    size_t length = strlen(needle);
+    for (const char *c = begin; c + length <= end; c++) {
+        c = (const char *) memchr(c, needle[0], end - c);
+        if (c == nullptr || c + length > end) return nullptr;
+        if (memcmp(c, needle, length) == 0) return c;
+    }
+    return nullptr;
 }
@@ -10,6 +10,10 @@ int main() {
     dfa *machine_dfa = ex_infusion();
     dfa *human_dfa = ex_human();
     dfa *prop = ex_prop();
+    if (machine_dfa == nullptr || human_dfa == nullptr || prop == nullptr) {
+        std::cerr << "Could not load the infusion pump models from ./ltsa_models" << std::endl;
+        return 1;
+    }
 
     prop->DFA_print(stdout);
 
@@ -24,11 +28,13 @@ int main() {
     std::cout << "-------------------------------------" << std::endl;
     std::flush(std::cout);
 
-    mapping_list mappings = modify_new_mapping();
-    patternlib_init(mappings);
+    pattern_library_t library;
+    patternlib_init(library);
     std::cout << "Machine DFA has " << machine_dfa->num_states << " states" << std::endl;
 
-    int res = modify_violate_property(*human_dfa, *machine_dfa, &p, &mappings, 9999);
+    modify_options_t options = modify_default_options();
+    options.num_threads = 0;
+    int res = modify_violate_property(*human_dfa, *machine_dfa, &p, &library.mappings, 9999, options);
     if (res == MODIFY_SUCCESSFUL) {
         std::cout << ">> Modify success -- now violates property" << std::endl;
         std::cout << "Modified DFA ------------------------" << std::endl;
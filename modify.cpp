@@ -6,8 +6,279 @@
  */
 
 #include "inc/modify.h"
+#include "inc/batch_check.h"
+#include "inc/dfa_file.h"
+#include "inc/incremental_check.h"
+#include "inc/monitor.h"
+#include "inc/mutant.h"
+#include "inc/pattern_match.h"
+#include "inc/slice.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+/* Outcomes of a single modification trial */
+#define TRIAL_NOT_FOUND     (0)
+#define TRIAL_SATISFIED     (1)
+#define TRIAL_VIOLATED      (2)
+
+/* Result of a single modification trial */
+typedef struct trial_result {
+    int outcome;                    /* One of the TRIAL_ outcomes */
+    std::unique_ptr<dfa> mutant;    /* Modified DFA, only built if it violates */
+    counterexample_t trace;         /* Shortest violating trace, if traces are saved */
+    dfa_digest_t digest;            /* Digest of the modified DFA's canonical form,
+                                     * if deduplicating */
+} trial_result_t;
+
+/* Hash of a digest, for use as an unordered container key */
+typedef struct digest_hasher {
+    size_t operator()(const dfa_digest_t &digest) const { return digest.low ^ digest.high; }
+} digest_hasher_t;
+
+/* Shared state of a campaign; workers take (group, trial) items from it and
+ * record their results in it, always while holding the lock.  Maps whose initial
+ * patterns are structurally equal form one group and share one entry of the match
+ * cache, so each instance is found exactly once and then modified into every
+ * target pattern of the group by the same work item. */
+typedef struct campaign {
+    dfa *modification_dfa;          /* DFA that will be modified */
+    dfa *machine_dfa;               /* DFA representing the machine, minimized if enabled */
+    dfa *original_machine;          /* Machine as given, before any slicing or minimization */
+    std::unique_ptr<dfa> sliced_machine;    /* Sliced machine, if enabled */
+    std::vector<int> relevant;      /* Symbols kept by slicing, if enabled */
+    std::unique_ptr<dfa> minimized_machine; /* Minimized machine, if enabled */
+    Property *p;                    /* Property that is aimed to be violated */
+    mapping_list *maps;             /* List of pattern maps that can be used */
+    std::unique_ptr<monitored_machine> monitor; /* Machine composed with the property,
+                                     * if enabled */
+    std::unique_ptr<incremental_checker> checker; /* Checker reusing the unmodified
+                                     * DFA's product, if enabled */
+    std::unique_ptr<batch_checker> batch; /* Checker of many modifications at once,
+                                     * if enabled */
+    monitor_alignment_t alignment;  /* Symbols of the unmodified DFA's product with the
+                                     * monitored machine, shared by every modification;
+                                     * if the monitored machine is enabled */
+    int batch_size;                 /* Number of modifications each worker takes and
+                                     * checks together, 1 if not batching */
+    bool traces;                    /* Whether counterexamples are recorded and saved */
+    bool binary;                    /* Whether mutants are also saved in binary */
+    bool dedupe;                    /* Whether verdicts are reused between modifications
+                                     * with equal canonical forms */
+    bool minimize_mutants;          /* Whether modifications are minimized before checks */
+
+    std::mutex verdict_lock;        /* Guards verdicts, apart from the campaign lock */
+    std::unordered_map<dfa_digest_t, int, digest_hasher_t> verdicts; /* Outcome of
+                                     * each canonical form checked so far */
+
+    std::mutex lock;
+    match_cache matches;            /* Instances of every group's initial pattern */
+    std::vector<std::vector<int>> groups;   /* Maps of each group, in map order */
+    std::vector<int> group_entries; /* Match cache entry of each group */
+    int current_group;              /* Group that the next item is taken from */
+    int next_trial;                 /* Trial that the next item is taken from */
+    std::vector<int> group_counts;  /* Number of trials of each group; max_per_map
+                                     * until the group's instances are found to run out */
+    int max_per_map;                /* Limit on the number of trials per map */
+    std::vector<int> trial_limits;  /* Number of trials of each map */
+    std::vector<std::vector<trial_result_t>> results; /* Results by map and trial */
+} campaign_t;
+
+/* Work item of a campaign: one instance of a group's initial pattern, modified into
+ * the target pattern of every map in the group */
+typedef struct campaign_item {
+    int group_no;                   /* Group of the item */
+    int trial;                      /* Trial of the item, the index of the instance */
+    pattern_output match;           /* Instance of the group's initial pattern */
+    std::vector<trial_result_t> results;    /* Result of each map of the group */
+} campaign_item_t;
+
+/* First-order modification which satisfies the property, to be combined with others */
+typedef struct application {
+    int map_no;                     /* Map that was applied */
+    int trial;                      /* Trial of the map, the index of the instance */
+    pattern_output match;           /* Instance of the map's initial pattern */
+    int approach;                   /* Fewest steps from an error state of any monitored
+                                     * state reachable with the modification, or INT_MAX */
+} application_t;
+
+/* Violating modification which rewrites several pattern instances together */
+typedef struct combination {
+    std::vector<std::pair<int, int>> parts; /* (map, trial) of each first-order part */
+    trial_result_t result;          /* Outcome and mutant */
+} combination_t;
+
+/* Storage of a worker, reused by every trial it runs.  Modifications are views
+ * over the unmodified DFA (see mutant.h); one is only written into the worker's
+ * copy of that DFA when it is needed in full, and reverted right after. */
+typedef struct campaign_scratch {
+    check_workspace workspace;      /* Search storage for the property checks */
+    std::vector<dfa_mutant> mutants;    /* Modification of each trial awaiting its check */
+    std::unique_ptr<dfa> modified;  /* Copy of the DFA that will be modified */
+} campaign_scratch_t;
+
+/** @brief Runs a single modification trial
+ *
+ * @param c Campaign the trial belongs to
+ * @param map Pattern map to apply
+ * @param match Instance of the map's initial pattern to modify
+ * @param scratch Storage of the worker running the trial
+ * @param result Where to store the outcome and violating mutant
+ */
+static void run_trial(campaign_t *c, pattern_map_t *map, const pattern_output &match,
+        campaign_scratch_t &scratch, trial_result_t &result);
+
+/** @brief Modifies the DFA for a trial, and settles the trial if no check is needed
+ *
+ * @param c Campaign the trial belongs to
+ * @param map Pattern map to apply
+ * @param match Instance of the map's initial pattern to modify
+ * @param mutant Where to store the modification, which awaits its check
+ * @param modified Copy of the DFA that will be modified, left unmodified on return
+ * @param result Where to store the outcome
+ * @param minimized Where to store the minimized modification, if enabled
+ * @return True if the modification must still be checked
+ */
+static bool trial_prepare(campaign_t *c, pattern_map_t *map, const pattern_output &match,
+        dfa_mutant &mutant, dfa &modified, trial_result_t &result, std::unique_ptr<dfa> &minimized);
+
+/** @brief Settles a modification if no check is needed, as trial_prepare
+ *
+ * @param c Campaign the modification belongs to
+ * @param mutant Modification, which awaits its check
+ * @param modified Copy of the DFA that will be modified, left unmodified on return
+ * @param result Where to store the outcome
+ * @param minimized Where to store the minimized modification, if enabled
+ * @return True if the modification must still be checked
+ */
+static bool trial_settle(campaign_t *c, const dfa_mutant &mutant, dfa &modified,
+        trial_result_t &result, std::unique_ptr<dfa> &minimized);
+
+/** @brief Checks a single modification, without batching
+ *
+ * @param c Campaign the modification belongs to
+ * @param mutant Modification to check
+ * @param minimized Minimized modification, if enabled, or nullptr
+ * @param scratch Storage of the worker checking it
+ * @param result Where to store the trace, if traces are saved
+ * @return True if the modification satisfies the property
+ */
+static bool trial_check(campaign_t *c, const dfa_mutant &mutant, dfa *minimized,
+        campaign_scratch_t &scratch, trial_result_t &result);
+
+/** @brief Records the verdict of a checked modification
+ *
+ * @param c Campaign the trial belongs to
+ * @param mutant Modification that was checked, built in full if it violates the property
+ * @param result Result of the trial
+ * @param satisfied Whether the modification satisfies the property
+ */
+static void trial_finish(campaign_t *c, const dfa_mutant &mutant, trial_result_t &result,
+        bool satisfied);
+
+/** @brief Runs the trials of some items, checking their modifications in batches
+ *
+ * @param c Campaign the items belong to
+ * @param items Items to run, with a result slot for every map of their group
+ * @param scratch Storage of the worker running the items
+ */
+static void run_batch(campaign_t *c, std::vector<campaign_item_t> &items, campaign_scratch_t &scratch);
+
+/** @brief Saves a violating modification, with its trace and binary form if enabled
+ *
+ * @param c Campaign the modification belongs to
+ * @param result Result of the modification
+ * @param number Number of the output files
+ */
+static void campaign_save(campaign_t *c, trial_result_t &result, int number);
+
+/** @brief Collects the first-order modifications that can be combined, closest to an
+ *      error state first
+ *
+ * @param c Campaign whose first-order trials are all done
+ * @param scratch Storage for the modifications and their searches
+ * @param applications Where to store the modifications
+ */
+static void combine_collect(campaign_t *c, campaign_scratch_t &scratch,
+        std::vector<application_t> &applications);
+
+/** @brief Measures how closely a modification comes to an error state
+ *
+ * @param c Campaign the modification belongs to
+ * @param mutant Modification, which must satisfy the property
+ * @param distances Distance of every monitored state from the error states
+ * @param workspace Storage for the visited set and frontier
+ * @return Fewest steps from an error state of any reachable monitored state, or
+ *      INT_MAX if none can reach one
+ */
+static int combine_approach(campaign_t *c, const dfa_mutant &mutant,
+        const std::vector<int> &distances, check_workspace &workspace);
+
+/** @brief Finds the next first-order modification that can extend a set
+ *
+ * @param applications First-order modifications
+ * @param parts Indexes of the set's modifications
+ * @param from Index to start from
+ * @return First index from there whose modification rewrites none of the set's
+ *      states, or the number of modifications if there is none
+ */
+static int combine_next(const std::vector<application_t> &applications,
+        const std::vector<int> &parts, int from);
+
+/** @brief Returns whether a set of first-order modifications contains a smaller
+ *      violating set
+ *
+ * @param parts Indexes of the set's modifications, in increasing order
+ * @param violating Sets already found to violate the property
+ * @return True if a proper subset of two or more modifications violates the property
+ */
+static bool combine_subsumed(const std::vector<int> &parts, const std::set<std::vector<int>> &violating);
+
+/** @brief Checks combinations of the first-order modifications that satisfy the property
+ *
+ * @param c Campaign whose first-order trials are all done
+ * @param options Options of the campaign, with its order and budget
+ * @param checked Where to store the number of modifications checked of each order
+ * @param found Where to store the violating combinations, lowest order first
+ * @return True if every combination was tried within the budget
+ */
+static bool combine_search(campaign_t *c, const modify_options_t &options,
+        std::vector<long> &checked, std::vector<combination_t> &found);
+
+/** @brief Takes the next (group, trial) item of a campaign
+ *
+ * The trial is reserved with the lock held, and its pattern instance is then found
+ * with the lock released, so matching never holds up other workers.
+ *
+ * @param c Campaign to take from
+ * @param guard Holder of the campaign lock, locked on entry and on return
+ * @param group_no Where to store the group of the item
+ * @param trial Where to store the trial of the item
+ * @param match Where to store the pattern instance of the item
+ * @return True if an item was taken, false if the campaign is exhausted
+ */
+static bool campaign_take(campaign_t *c, std::unique_lock<std::mutex> &guard, int &group_no,
+        int &trial, pattern_output &match);
+
+/** @brief Worker loop which takes and runs items until the campaign is exhausted
+ *
+ * @param c Campaign to work on
+ */
+static void campaign_worker(campaign_t *c);
+
+/* *****     IMPLEMENTATION     ***** */
+
 
 pattern_map_t *modify_new_pattern_map(dfa &pattern1, dfa &pattern2) {
     auto *new_map = new pattern_map_t;
@@ -16,6 +287,26 @@ pattern_map_t *modify_new_pattern_map(dfa &pattern1, dfa &pattern2) {
     return new_map;
 }
 
+modify_options_t modify_default_options() {
+    modify_options_t options;
+    options.num_threads = 1;
+    options.incremental = true;
+    options.precompose = true;
+    options.monitor_cache = nullptr;
+    options.traces = false;
+    options.binary = false;
+    options.dedupe = false;
+    options.minimize_machine = false;
+    options.slice_machine = false;
+    options.minimize_mutants = false;
+    options.batch_size = 1;
+    options.engine = check_engine::BFS;
+    options.order = 1;
+    options.max_trials = 0;
+    options.time_limit = 0;
+    return options;
+}
+
 mapping_list modify_new_mapping() {
     mapping_list m;
     return m;
@@ -27,44 +318,618 @@ void modify_add_to_mappings(mapping_list &current_map, pattern_map_t &next) {
 
 int modify_violate_property(dfa &modification_dfa, dfa &machine_dfa, Property *p,
         mapping_list *maps, int max_per_map) {
+    return modify_violate_property(modification_dfa, machine_dfa, p, maps, max_per_map,
+            modify_default_options());
+}
+
+int modify_violate_property(dfa &modification_dfa, dfa &machine_dfa, Property *p,
+        mapping_list *maps, int max_per_map, const modify_options_t &options) {
     int succ_count = 0;
-    dfa *dest;
-    dfa *modification_dfa_copy;
+    int num_maps = maps->size();
+    int num_threads = options.num_threads > 0 ? options.num_threads :
+            std::max(1u, std::thread::hardware_concurrency());
 
-    int err_flag;
-    for(auto const& map: *maps) {
+    campaign_t c;
+    c.modification_dfa = &modification_dfa;
+    c.original_machine = &machine_dfa;
+    c.machine_dfa = &machine_dfa;
+    if (options.slice_machine) {
+        /* The modified DFA's alphabet is the same for every modification */
+        c.relevant = slice_relevant(modification_dfa, machine_dfa, *p);
+        c.sliced_machine.reset(slice_hide(machine_dfa, c.relevant, nullptr));
+        c.machine_dfa = c.sliced_machine.get();
+    }
+    if (options.minimize_machine) {
+        c.minimized_machine.reset(c.machine_dfa->DFA_minimize(nullptr));
+        c.machine_dfa = c.minimized_machine.get();
+    }
+    c.p = p;
+    c.maps = maps;
+    bool batched = options.batch_size > 1 && !options.traces && !options.minimize_mutants;
+    if (options.precompose || options.incremental || batched || options.order > 1) {
+        if (options.monitor_cache != nullptr) {
+            c.monitor.reset(monitor_load(options.monitor_cache, *p, *c.machine_dfa, options.engine));
+        }
+        if (!c.monitor) {
+            c.monitor.reset(new monitored_machine(*p, *c.machine_dfa, options.engine));
+            if (options.monitor_cache != nullptr &&
+                    c.monitor->save(options.monitor_cache) != DFAFILE_NO_ERROR) {
+                fprintf(stderr, "Could not save the monitored machine to %s\n", options.monitor_cache);
+            }
+        }
+    }
+    if (c.monitor) {
+        c.alignment = c.monitor->align(modification_dfa);
+    }
+    c.traces = options.traces;
+    c.binary = options.binary;
+    c.dedupe = options.dedupe;
+    c.minimize_mutants = options.minimize_mutants;
+    c.batch_size = 1;
+    if (batched) {
+        c.batch.reset(new batch_checker(*c.monitor, modification_dfa));
+        c.batch_size = std::min(options.batch_size, BATCH_MAX_LANES);
+    } else if (options.incremental && !options.traces && !options.minimize_mutants) {
+        c.checker.reset(new incremental_checker(*c.monitor, modification_dfa));
+    }
+    c.current_group = 0;
+    c.next_trial = 0;
+    c.max_per_map = std::max(max_per_map, 0);
+    c.trial_limits.assign(num_maps, c.max_per_map);
+    c.results.resize(num_maps);
+    for(int map_no = 0; map_no < num_maps; map_no++) {
+        pattern_map_t *map = (*maps)[map_no];
+        if (map->initial->num_states != map->target->num_states ||
+                map->initial->alphabet_size != map->target->alphabet_size ||
+                map->initial->num_states > modification_dfa.num_states) {
+            c.trial_limits[map_no] = 0;
+            continue;
+        }
+        int entry = c.matches.lookup(modification_dfa, *(map->initial));
+        auto it = std::find(c.group_entries.begin(), c.group_entries.end(), entry);
+        if (it == c.group_entries.end()) {
+            c.group_entries.push_back(entry);
+            c.groups.emplace_back(1, map_no);
+        } else {
+            c.groups[it - c.group_entries.begin()].push_back(map_no);
+        }
+    }
+
+    c.group_counts.assign(c.groups.size(), c.max_per_map);
+
+    std::vector<std::thread> workers;
+    for(int i = 1; i < num_threads; i++) {
+        workers.emplace_back(campaign_worker, &c);
+    }
+    campaign_worker(&c);
+    for(auto &worker : workers) {
+        worker.join();
+    }
+    for(int group_no = 0; group_no < c.groups.size(); group_no++) {
+        for (int map_no : c.groups[group_no]) {
+            c.trial_limits[map_no] = c.group_counts[group_no];
+        }
+    }
+
+    std::vector<long> checked;
+    std::vector<combination_t> found;
+    bool complete = true;
+    if (options.order > 1) {
+        complete = combine_search(&c, options, checked, found);
+    }
+
+    for(int map_no = 0; map_no < num_maps; map_no++) {
         std::cout << "Map: ";
-        for(int trial = 0; trial < max_per_map; trial++) {
-            std::flush(std::cout);
-            modification_dfa_copy = new dfa(modification_dfa);
-            if ((err_flag = modification_dfa_copy->DFA_modify(*(map->initial), *(map->target), trial)) < 0) {
-                std::cout << trial;
-                break;
+        for(int trial = 0; trial < c.trial_limits[map_no]; trial++) {
+            trial_result_t &result = c.results[map_no][trial];
+            if (result.outcome == TRIAL_VIOLATED) {
+                campaign_save(&c, result, succ_count);
+                succ_count++;
+                std::cout << "!";
             } else {
-                dest = new dfa(*modification_dfa_copy, machine_dfa);
-//                if ((err_flag = DFA_parallel(&dest, modification_dfa_copy, machine_dfa)) < 0) {
-//                    std::cout << "Composition Failed with code " << err_flag << std::endl;
-                /*} else */if (!(p->property_check(*dest))) {
-                    char outname[8];
-                    snprintf(outname, 8, "%d.out", succ_count);
-                    FILE *outfile = fopen(outname, "w+");
-                    if (outfile == nullptr) {
-                        perror("Error saving output: ");
-                        exit(1);
-                    }
-                    modification_dfa.DFA_print(outfile);
-                    fclose(outfile);
-                    succ_count++;
-                    std::cout << "!";
-                } else {
-                    std::cout << ".";
-                }
+                std::cout << ".";
             }
         }
+        if (c.trial_limits[map_no] < max_per_map) {
+            std::cout << c.trial_limits[map_no];
+        }
         std::cout << std::endl;
     }
-    free(modification_dfa_copy);
+
+    /* Combinations are listed by order, each with the instances it rewrites */
+    int next_found = 0;
+    for(int order = 2; order < checked.size(); order++) {
+        int num_found = 0;
+        while (next_found + num_found < found.size() && found[next_found + num_found].parts.size() == order) {
+            num_found++;
+        }
+        std::cout << "Order " << order << ": " << checked[order] << " checked, " << num_found <<
+                " violating" << std::endl;
+        for(; num_found > 0; num_found--, next_found++) {
+            combination_t &combination = found[next_found];
+            campaign_save(&c, combination.result, succ_count);
+            std::cout << "  " << succ_count << ".out:";
+            for(int i = 0; i < combination.parts.size(); i++) {
+                std::cout << (i == 0 ? " map " : " + map ") << combination.parts[i].first <<
+                        " instance " << combination.parts[i].second;
+            }
+            std::cout << std::endl;
+            succ_count++;
+        }
+    }
+    if (!complete) {
+        std::cout << "Combinations stopped at the budget" << std::endl;
+    }
     std::cout << "Number of violating machines:" << succ_count << std::endl;
+
+    /* Counted in (map, trial) order, so the count does not depend on which worker
+     * reached a canonical form first; combinations are not counted */
+    if (c.dedupe) {
+        std::unordered_set<dfa_digest_t, digest_hasher_t> seen;
+        int duplicates = 0;
+        for(int map_no = 0; map_no < num_maps; map_no++) {
+            for(int trial = 0; trial < c.trial_limits[map_no]; trial++) {
+                trial_result_t &result = c.results[map_no][trial];
+                if (result.outcome != TRIAL_NOT_FOUND && !seen.insert(result.digest).second) {
+                    duplicates++;
+                }
+            }
+        }
+        std::cout << "Number of duplicate first-order machines skipped:" << duplicates << std::endl;
+    }
     return succ_count > 0 ? MODIFY_SUCCESSFUL : MODIFY_NOT_FOUND;
 }
 
+static void run_trial(campaign_t *c, pattern_map_t *map, const pattern_output &match,
+        campaign_scratch_t &scratch, trial_result_t &result) {
+    dfa_mutant &mutant = scratch.mutants[0];
+    std::unique_ptr<dfa> minimized;
+    if (!trial_prepare(c, map, match, mutant, *scratch.modified, result, minimized)) {
+        return;
+    }
+    bool satisfied = trial_check(c, mutant, minimized.get(), scratch, result);
+    trial_finish(c, mutant, result, satisfied);
+}
+
+static bool trial_prepare(campaign_t *c, pattern_map_t *map, const pattern_output &match,
+        dfa_mutant &mutant, dfa &modified, trial_result_t &result, std::unique_ptr<dfa> &minimized) {
+    mutant.clear();
+    if (mutant.modify(*(map->initial), *(map->target), match) < 0) {
+        result.outcome = TRIAL_NOT_FOUND;
+        return false;
+    }
+    return trial_settle(c, mutant, modified, result, minimized);
+}
+
+static bool trial_settle(campaign_t *c, const dfa_mutant &mutant, dfa &modified,
+        trial_result_t &result, std::unique_ptr<dfa> &minimized) {
+    if (!c->minimize_mutants && !c->dedupe) {
+        return true;
+    }
+
+    /* The minimized modification is its canonical form, so its digest is the same */
+    mutant.write(modified);
+    if (c->minimize_mutants) {
+        minimized.reset(modified.DFA_minimize(nullptr));
+    }
+    if (c->dedupe) {
+        result.digest = minimized ? minimized->DFA_digest() : modified.DFA_canonical_digest();
+    }
+    mutant.revert(modified);
+
+    /* A modification equivalent to one already checked has the same verdict; when
+     * traces are saved, violating ones are still checked to trace their own states */
+    if (c->dedupe) {
+        std::lock_guard<std::mutex> guard(c->verdict_lock);
+        auto it = c->verdicts.find(result.digest);
+        if (it != c->verdicts.end() && !(it->second == TRIAL_VIOLATED && c->traces)) {
+            result.outcome = it->second;
+            if (result.outcome == TRIAL_VIOLATED) result.mutant.reset(mutant.to_dfa());
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool trial_check(campaign_t *c, const dfa_mutant &mutant, dfa *minimized,
+        campaign_scratch_t &scratch, trial_result_t &result) {
+    if (c->checker) {
+        return c->checker->check(mutant, scratch.workspace);
+    }
+    dfa &modified = *scratch.modified;
+    mutant.write(modified);
+    dfa *checked = minimized != nullptr ? minimized : &modified;
+    bool satisfied;
+    if (c->monitor) {
+        satisfied = c->monitor->check(*checked, c->alignment, scratch.workspace,
+                c->traces ? &result.trace : nullptr);
+    } else {
+        satisfied = c->p->property_check(*checked, *c->machine_dfa, scratch.workspace,
+                c->traces ? &result.trace : nullptr);
+    }
+    if (!satisfied && c->traces) {
+        /* Report states of the models as given rather than of their minimized or
+         * sliced forms; slicing also drops the machine's hidden actions from the trace.
+         * The machine as given has the final say if the two ever disagree. */
+        if (c->sliced_machine) {
+            satisfied = !slice_restore(&result.trace, modified, *c->original_machine, *c->p,
+                    c->relevant, scratch.workspace);
+        } else {
+            if (minimized != nullptr) counterexample_replay(&result.trace, 0, modified);
+            if (c->minimized_machine) counterexample_replay(&result.trace, 1, *c->original_machine);
+        }
+    }
+    mutant.revert(modified);
+    return satisfied;
+}
+
+static void trial_finish(campaign_t *c, const dfa_mutant &mutant, trial_result_t &result,
+        bool satisfied) {
+    if (!satisfied) {
+        result.outcome = TRIAL_VIOLATED;
+        result.mutant.reset(mutant.to_dfa());
+    } else {
+        result.outcome = TRIAL_SATISFIED;
+    }
+    if (c->dedupe) {
+        std::lock_guard<std::mutex> guard(c->verdict_lock);
+        c->verdicts.insert({result.digest, result.outcome});
+    }
+}
+
+static void run_batch(campaign_t *c, std::vector<campaign_item_t> &items, campaign_scratch_t &scratch) {
+    std::vector<trial_result_t*> pending;
+    std::vector<const dfa_mutant*> mutants;
+    std::unique_ptr<dfa> minimized;
+    for (campaign_item_t &item : items) {
+        const std::vector<int> &group = c->groups[item.group_no];
+        for (int i = 0; i < group.size(); i++) {
+            /* A view is only used up by a modification that awaits its check */
+            if (scratch.mutants.size() <= pending.size()) scratch.mutants.emplace_back(*c->modification_dfa);
+            if (trial_prepare(c, (*c->maps)[group[i]], item.match, scratch.mutants[pending.size()],
+                    *scratch.modified, item.results[i], minimized)) {
+                pending.push_back(&item.results[i]);
+            }
+        }
+    }
+
+    /* Up to batch_size modifications are checked in each search */
+    for (int start = 0; start < pending.size(); start += c->batch_size) {
+        int end = std::min<int>(start + c->batch_size, pending.size());
+        mutants.clear();
+        for (int i = start; i < end; i++) mutants.push_back(&scratch.mutants[i]);
+        uint64_t satisfied = c->batch->check(mutants, scratch.workspace);
+        for (int i = start; i < end; i++) {
+            trial_finish(c, scratch.mutants[i], *pending[i], (satisfied >> (i - start)) & 1);
+        }
+    }
+}
+
+static void campaign_save(campaign_t *c, trial_result_t &result, int number) {
+    char outname[16];
+    snprintf(outname, sizeof(outname), "%d.out", number);
+    FILE *outfile = fopen(outname, "w+");
+    if (outfile == nullptr) {
+        perror("Error saving output: ");
+        exit(1);
+    }
+    result.mutant->DFA_print(outfile);
+    fclose(outfile);
+    if (c->traces) {
+        snprintf(outname, sizeof(outname), "%d.trace", number);
+        outfile = fopen(outname, "w+");
+        if (outfile == nullptr) {
+            perror("Error saving trace: ");
+            exit(1);
+        }
+        counterexample_print(result.trace, outfile);
+        fclose(outfile);
+    }
+    if (c->binary) {
+        snprintf(outname, sizeof(outname), "%d.dfa", number);
+        if (dfafile_write(outname, *result.mutant, std::set<int>()) != DFAFILE_NO_ERROR) {
+            perror("Error saving binary output: ");
+            exit(1);
+        }
+    }
+}
+
+static void combine_collect(campaign_t *c, campaign_scratch_t &scratch,
+        std::vector<application_t> &applications) {
+    const dfa &base = *c->modification_dfa;
+    int alphabet_size = base.alphabet_size;
+    std::vector<int> distances = c->monitor->error_distances();
+    dfa_mutant &mutant = scratch.mutants[0];
+
+    std::vector<int> map_group(c->maps->size(), -1);
+    for (int group_no = 0; group_no < c->groups.size(); group_no++) {
+        for (int map_no : c->groups[group_no]) map_group[map_no] = group_no;
+    }
+    for (int map_no = 0; map_no < c->maps->size(); map_no++) {
+        pattern_map_t *map = (*c->maps)[map_no];
+        for (int trial = 0; trial < c->trial_limits[map_no]; trial++) {
+            if (c->results[map_no][trial].outcome != TRIAL_SATISFIED) {
+                continue;
+            }
+            application_t application;
+            application.map_no = map_no;
+            application.trial = trial;
+            c->matches.instance(c->group_entries[map_group[map_no]], trial, application.match);
+            mutant.clear();
+            mutant.modify(*(map->initial), *(map->target), application.match);
+
+            /* A rewrite which leaves every row as it was adds nothing to a combination */
+            bool changed = false;
+            for (int s : mutant.touched_states()) {
+                const int *row = mutant.row(s);
+                changed |= !std::equal(row, row + alphabet_size,
+                        &base.transition_matrix[(size_t) s * alphabet_size]);
+            }
+            if (!changed) {
+                continue;
+            }
+            application.approach = combine_approach(c, mutant, distances, scratch.workspace);
+            applications.push_back(std::move(application));
+        }
+    }
+    std::stable_sort(applications.begin(), applications.end(),
+            [](const application_t &a, const application_t &b) { return a.approach < b.approach; });
+}
+
+static int combine_approach(campaign_t *c, const dfa_mutant &mutant,
+        const std::vector<int> &distances, check_workspace &workspace) {
+    const dfa &monitor_dfa = *c->monitor->product;
+    int num_symbols = c->alignment.human_symbols.size();
+    uint64_t num_monitor_states = monitor_dfa.num_states;
+    workspace.reset((uint64_t) mutant.get_base().num_states * num_monitor_states);
+    uint64_t first = mutant.get_base().initial_state * num_monitor_states + monitor_dfa.initial_state;
+    workspace.visit(first);
+    workspace.push(first);
+
+    int approach = distances[monitor_dfa.initial_state] < 0 ? INT_MAX : distances[monitor_dfa.initial_state];
+    while (!workspace.empty()) {
+        uint64_t current = workspace.pop();
+        int h = current / num_monitor_states;
+        int m = current % num_monitor_states;
+        const int *row = mutant.row(h);
+        for (int k = 0; k < num_symbols; k++) {
+            int h_symbol = c->alignment.human_symbols[k];
+            int m_symbol = c->alignment.monitor_symbols[k];
+            int h_target = h_symbol < 0 ? h : row[h_symbol];
+            int m_target = m_symbol < 0 ? m : monitor_dfa.apply(m, m_symbol);
+            if (h_target == DFA_DUMMY_SYMBOL || m_target == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+            if (distances[m_target] >= 0) approach = std::min(approach, distances[m_target]);
+            uint64_t next = h_target * num_monitor_states + m_target;
+            if (workspace.visit(next)) {
+                workspace.push(next);
+            }
+        }
+    }
+    return approach;
+}
+
+static int combine_next(const std::vector<application_t> &applications,
+        const std::vector<int> &parts, int from) {
+    for (; from < applications.size(); from++) {
+        bool disjoint = true;
+        for (int i : parts) {
+            const std::vector<int> &states = applications[i].match.states;
+            for (int s : applications[from].match.states) {
+                disjoint &= std::find(states.begin(), states.end(), s) == states.end();
+            }
+        }
+        if (disjoint) break;
+    }
+    return from;
+}
+
+static bool combine_subsumed(const std::vector<int> &parts, const std::set<std::vector<int>> &violating) {
+    /* Every proper subset of two or more parts, as a bit mask over the parts */
+    int order = parts.size();
+    std::vector<int> subset;
+    for (int mask = 1; mask < (1 << order) - 1; mask++) {
+        if (__builtin_popcount(mask) < 2) continue;
+        subset.clear();
+        for (int i = 0; i < order; i++) {
+            if (mask & (1 << i)) subset.push_back(parts[i]);
+        }
+        if (violating.count(subset)) return true;
+    }
+    return false;
+}
+
+static bool combine_search(campaign_t *c, const modify_options_t &options,
+        std::vector<long> &checked, std::vector<combination_t> &found) {
+    campaign_scratch_t scratch;
+    scratch.mutants.emplace_back(*c->modification_dfa);
+    scratch.modified.reset(new dfa(*c->modification_dfa));
+    std::vector<application_t> applications;
+    combine_collect(c, scratch, applications);
+    int num_applications = applications.size();
+    int max_order = std::min(options.order, MODIFY_MAX_ORDER);
+    checked.assign(max_order + 1, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    long num_checked = 0;
+    auto exhausted = [&]() {
+        if (options.max_trials > 0 && num_checked >= options.max_trials) return true;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return options.time_limit > 0 && elapsed.count() >= options.time_limit;
+    };
+
+    /* Sets hold indexes into applications in increasing order, so each set of
+     * commuting modifications is built once, and only from disjoint ones.  A set of
+     * order k extends a satisfying set of order k - 1 by a larger index.  All sets of
+     * one order are checked before the next, so those containing a violating set
+     * are known and skipped. */
+    std::set<std::vector<int>> violating;
+    std::vector<std::vector<int>> bases;    /* Satisfying sets of the previous order */
+    std::vector<std::vector<int>> satisfying;   /* Satisfying sets of this order */
+    for (int i = 0; i < num_applications; i++) bases.push_back({i});
+    std::vector<std::vector<int>> pending;  /* Sets awaiting a batched check */
+    std::vector<trial_result_t> pending_results;
+    auto record = [&](const std::vector<int> &parts, trial_result_t &result) {
+        if (result.outcome != TRIAL_VIOLATED) {
+            satisfying.push_back(parts);
+            return;
+        }
+        violating.insert(parts);
+        if (!result.mutant) return;
+        combination_t combination;
+        for (int i : parts) combination.parts.emplace_back(applications[i].map_no, applications[i].trial);
+        std::sort(combination.parts.begin(), combination.parts.end());
+        combination.result = std::move(result);
+        found.push_back(std::move(combination));
+    };
+    auto flush = [&]() {
+        std::vector<const dfa_mutant*> mutants;
+        for (int i = 0; i < pending.size(); i++) mutants.push_back(&scratch.mutants[i]);
+        uint64_t satisfied = c->batch->check(mutants, scratch.workspace);
+        for (int i = 0; i < pending.size(); i++) {
+            trial_finish(c, scratch.mutants[i], pending_results[i], (satisfied >> i) & 1);
+            record(pending[i], pending_results[i]);
+        }
+        pending.clear();
+        pending_results.clear();
+    };
+
+    bool complete = true;
+    for (int order = 2; order <= max_order && !bases.empty(); order++) {
+        /* Applications are sorted by approach, so each base's extensions come in order
+         * of their sum of approaches; merging them over all bases takes the sets of
+         * this order closest to an error first.  Entries are (sum, base, extension) */
+        typedef std::pair<long long, std::pair<int, int>> extension_t;
+        std::priority_queue<extension_t, std::vector<extension_t>, std::greater<extension_t>> frontier;
+        std::vector<long long> base_sums(bases.size(), 0);
+        auto extend = [&](int base_no, int from) {
+            int next = combine_next(applications, bases[base_no], from);
+            if (next < num_applications) {
+                frontier.push({base_sums[base_no] + applications[next].approach, {base_no, next}});
+            }
+        };
+        for (int base_no = 0; base_no < bases.size(); base_no++) {
+            for (int i : bases[base_no]) base_sums[base_no] += applications[i].approach;
+            extend(base_no, bases[base_no].back() + 1);
+        }
+
+        while (!frontier.empty()) {
+            if (exhausted()) {
+                complete = false;
+                break;
+            }
+            int base_no = frontier.top().second.first;
+            int next = frontier.top().second.second;
+            frontier.pop();
+            extend(base_no, next + 1);
+            std::vector<int> parts = bases[base_no];
+            parts.push_back(next);
+            if (combine_subsumed(parts, violating)) {
+                continue;
+            }
+
+            /* Each set awaiting a batched check keeps its own view */
+            if (scratch.mutants.size() <= pending.size()) scratch.mutants.emplace_back(*c->modification_dfa);
+            dfa_mutant &mutant = scratch.mutants[c->batch ? pending.size() : 0];
+            mutant.clear();
+            for (int i : parts) {
+                pattern_map_t *map = (*c->maps)[applications[i].map_no];
+                mutant.modify(*(map->initial), *(map->target), applications[i].match);
+            }
+            trial_result_t result;
+            std::unique_ptr<dfa> minimized;
+            if (!trial_settle(c, mutant, *scratch.modified, result, minimized)) {
+                /* Equivalent to a modification already checked, so only its verdict
+                 * is kept; a violating one was reported already */
+                result.mutant.reset();
+                record(parts, result);
+                continue;
+            }
+            num_checked++;
+            checked[order]++;
+            if (c->batch) {
+                pending.push_back(parts);
+                pending_results.push_back(std::move(result));
+                if (pending.size() == c->batch_size) flush();
+            } else {
+                trial_finish(c, mutant, result, trial_check(c, mutant, minimized.get(), scratch, result));
+                record(parts, result);
+            }
+        }
+        if (!pending.empty()) flush();
+        if (!complete) break;
+        bases.swap(satisfying);
+        satisfying.clear();
+    }
+    return complete;
+}
+
+static bool campaign_take(campaign_t *c, std::unique_lock<std::mutex> &guard, int &group_no,
+        int &trial, pattern_output &match) {
+    while (c->current_group < c->groups.size()) {
+        if (c->next_trial >= c->group_counts[c->current_group]) {
+            /* Move on to the next group */
+            c->current_group++;
+            c->next_trial = 0;
+            continue;
+        }
+        group_no = c->current_group;
+        trial = c->next_trial++;
+
+        guard.unlock();
+        bool found = c->matches.instance(c->group_entries[group_no], trial, match);
+        guard.lock();
+        if (found) {
+            return true;
+        }
+        /* Instances are found in order, so the group has exactly this many */
+        c->group_counts[group_no] = std::min(c->group_counts[group_no], trial);
+    }
+    return false;
+}
+
+static void campaign_worker(campaign_t *c) {
+    campaign_scratch_t scratch;
+    scratch.mutants.emplace_back(*c->modification_dfa);
+    scratch.modified.reset(new dfa(*c->modification_dfa));
+    std::vector<campaign_item_t> items;
+
+    std::unique_lock<std::mutex> guard(c->lock);
+    while (true) {
+        for (campaign_item_t &item : items) {
+            for (int i = 0; i < item.results.size(); i++) {
+                int map_no = c->groups[item.group_no][i];
+                if (c->results[map_no].size() <= item.trial) c->results[map_no].resize(item.trial + 1);
+                c->results[map_no][item.trial] = std::move(item.results[i]);
+            }
+        }
+        items.clear();
+
+        /* Items are taken whole, with one modification per map of their group, until
+         * there are enough modifications to fill a batch */
+        int num_trials = 0;
+        campaign_item_t item;
+        while (num_trials < c->batch_size &&
+                campaign_take(c, guard, item.group_no, item.trial, item.match)) {
+            item.results.clear();
+            item.results.resize(c->groups[item.group_no].size());
+            num_trials += item.results.size();
+            items.push_back(std::move(item));
+        }
+        if (items.empty()) break;
+
+        guard.unlock();
+        if (c->batch) {
+            run_batch(c, items, scratch);
+        } else {
+            for (campaign_item_t &taken : items) {
+                const std::vector<int> &group = c->groups[taken.group_no];
+                for (int i = 0; i < group.size(); i++) {
+                    run_trial(c, (*c->maps)[group[i]], taken.match, scratch, taken.results[i]);
+                }
+            }
+        }
+        guard.lock();
+    }
+}
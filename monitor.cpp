@@ -0,0 +1,290 @@
+/** @file monitor.cpp
+ *  @brief Monitored machines
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <unordered_map>
+#include "inc/monitor.h"
+
+/** @brief Recovers the machine and property states that make up each state of a
+ *      composition, checking that it is the composition of the two
+ *
+ * @param product Composition to check
+ * @param error_states Error states of the composition
+ * @param p Property the composition should monitor
+ * @param machine DFA representing the machine
+ * @param pairs Where to store the (machine, property) state of each state
+ * @return True if product is the monitored machine of the machine and property
+ */
+static bool monitor_components(const dfa& product, const std::set<int>& error_states,
+        Property& p, const dfa& machine, std::vector<std::pair<int, int>>& pairs);
+
+/* *****     IMPLEMENTATION     ***** */
+
+monitored_machine::monitored_machine(Property& p, dfa& machine, check_engine_t engine) {
+    dfa& prop_dfa = p.get_dfa();
+    auto alphabet = DFA_union_alphabet(machine, prop_dfa);
+    int alphabet_size = alphabet->symbols.size();
+    auto machine_symbols = std::vector<int>(alphabet_size);
+    auto prop_symbols = std::vector<int>(alphabet_size);
+    this->machine_symbol.resize(alphabet_size);
+    for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+        machine_symbols[symb_ind] = machine.get_symbol_index(alphabet->symbols[symb_ind]);
+        prop_symbols[symb_ind] = prop_dfa.get_symbol_index(alphabet->symbols[symb_ind]);
+        this->machine_symbol[symb_ind] = machine_symbols[symb_ind] >= 0;
+    }
+
+    /* Worklist expansion from the pair of initial states; states are numbered in
+     * discovery order, so rows are appended exactly in state order */
+    long long num_prop_states = prop_dfa.num_states;
+    std::unordered_map<long long, int> pair_ids;
+    auto pairs = std::vector<std::pair<int, int>>();
+    auto transitions = std::vector<int>();
+    auto finals = std::vector<bool>();
+
+    pairs.emplace_back(machine.initial_state, prop_dfa.initial_state);
+    pair_ids.insert({machine.initial_state * num_prop_states + prop_dfa.initial_state, 0});
+    for (int current = 0; current < pairs.size(); current++) {
+        int m = pairs[current].first;
+        int q = pairs[current].second;
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            int m_target = machine_symbols[symb_ind] < 0 ? m : machine.apply(m, machine_symbols[symb_ind]);
+            if (m_target == DFA_DUMMY_SYMBOL) {
+                transitions.push_back(DFA_DUMMY_SYMBOL);
+                continue;
+            }
+            int q_target = prop_symbols[symb_ind] < 0 ? DFA_INVALID_SYMBOL :
+                    prop_dfa.apply(q, prop_symbols[symb_ind]);
+            if (q_target < 0) {
+                q_target = q;
+            }
+            if (!p.can_reach_error(q_target)) {
+                /* Nothing past this step can violate the property */
+                transitions.push_back(DFA_DUMMY_SYMBOL);
+                continue;
+            }
+            auto inserted = pair_ids.insert({m_target * num_prop_states + q_target, (int) pairs.size()});
+            if (inserted.second) {
+                pairs.emplace_back(m_target, q_target);
+            }
+            transitions.push_back(inserted.first->second);
+        }
+        finals.push_back(machine.final_states.count(m) > 0);
+        this->error.push_back(p.is_error_state(q));
+    }
+
+    this->product.reset(new dfa(pairs.size(), 0, finals, alphabet, transitions.data()));
+    this->product->component_states = std::move(pairs);
+    if (engine == check_engine::BITSET) {
+        this->bitset.reset(new bitset_checker(*this->product, this->error, false));
+    }
+}
+
+monitored_machine::monitored_machine(dfa *product, const std::set<int>& error_states,
+        const dfa& machine, check_engine_t engine) {
+    this->product.reset(product);
+    for (int symbol_id : product->alphabet->symbols) {
+        this->machine_symbol.push_back(machine.get_symbol_index(symbol_id) >= 0);
+    }
+    this->error.assign(product->num_states, false);
+    for (int s : error_states) {
+        if (s >= 0 && s < product->num_states) this->error[s] = true;
+    }
+    if (engine == check_engine::BITSET) {
+        this->bitset.reset(new bitset_checker(*this->product, this->error, false));
+    }
+}
+
+int monitored_machine::save(const char *path) const {
+    std::set<int> error_states;
+    for (int s = 0; s < this->product->num_states; s++) {
+        if (this->error[s]) error_states.insert(s);
+    }
+    return dfafile_write(path, *this->product, error_states);
+}
+
+monitored_machine *monitor_load(const char *path, Property& p, dfa& machine, check_engine_t engine) {
+    std::set<int> error_states;
+    std::unique_ptr<dfa> product(dfafile_load(path, &error_states));
+    std::vector<std::pair<int, int>> pairs;
+    if (!product || !monitor_components(*product, error_states, p, machine, pairs)) {
+        return nullptr;
+    }
+    product->component_states = std::move(pairs);
+    return new monitored_machine(product.release(), error_states, machine, engine);
+}
+
+static bool monitor_components(const dfa& product, const std::set<int>& error_states,
+        Property& p, const dfa& machine, std::vector<std::pair<int, int>>& pairs) {
+    dfa& prop_dfa = p.get_dfa();
+    auto alphabet = DFA_union_alphabet(machine, prop_dfa);
+    if (product.alphabet->symbols != alphabet->symbols) {
+        return false;
+    }
+    int alphabet_size = alphabet->symbols.size();
+    std::vector<int> machine_symbols = product.DFA_align_alphabet(machine);
+    std::vector<int> prop_symbols = product.DFA_align_alphabet(prop_dfa);
+
+    /* Walk the composition alongside both components, as the constructor built it */
+    pairs.assign(product.num_states, std::make_pair(-1, -1));
+    pairs[product.initial_state] = std::make_pair(machine.initial_state, prop_dfa.initial_state);
+    std::vector<int> queue = {product.initial_state};
+    for (int i = 0; i < queue.size(); i++) {
+        int s = queue[i];
+        int m = pairs[s].first;
+        int q = pairs[s].second;
+        if ((product.final_states.count(s) > 0) != (machine.final_states.count(m) > 0) ||
+                (error_states.count(s) > 0) != p.is_error_state(q)) {
+            return false;
+        }
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            int m_target = machine_symbols[symb_ind] < 0 ? m : machine.apply(m, machine_symbols[symb_ind]);
+            int q_target = prop_symbols[symb_ind] < 0 ? DFA_INVALID_SYMBOL :
+                    prop_dfa.apply(q, prop_symbols[symb_ind]);
+            if (q_target < 0) {
+                q_target = q;
+            }
+            int target = product.apply(s, symb_ind);
+            if (m_target == DFA_DUMMY_SYMBOL || !p.can_reach_error(q_target)) {
+                if (target != DFA_DUMMY_SYMBOL) return false;
+                continue;
+            }
+            if (target < 0) {
+                return false;
+            }
+            if (pairs[target].first < 0) {
+                pairs[target] = std::make_pair(m_target, q_target);
+                queue.push_back(target);
+            } else if (pairs[target] != std::make_pair(m_target, q_target)) {
+                return false;
+            }
+        }
+    }
+    return queue.size() == product.num_states;
+}
+
+monitor_alignment_t monitored_machine::align(const dfa& human) const {
+    monitor_alignment_t alignment;
+    auto alphabet = DFA_union_alphabet(human, *this->product);
+    for (int symbol_id : alphabet->symbols) {
+        int human_index = human.get_symbol_index(symbol_id);
+        int monitor_index = this->product->get_symbol_index(symbol_id);
+        /* Symbols only the property knows can never fire */
+        if (human_index < 0 && !this->machine_symbol[monitor_index]) continue;
+        alignment.symbols.push_back(symbol_id);
+        alignment.human_symbols.push_back(human_index);
+        alignment.monitor_symbols.push_back(monitor_index);
+    }
+    return alignment;
+}
+
+std::vector<int> monitored_machine::error_distances() const {
+    const dfa& product = *this->product;
+    int num_states = product.num_states;
+    int alphabet_size = product.alphabet_size;
+
+    /* Breadth-first search backwards from every error state, over the edges of
+     * symbols that can fire */
+    std::vector<int> pred_start(num_states + 1, 0);
+    std::vector<int> preds;
+    for (int s = 0; s < num_states; s++) {
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            int t = product.apply(s, symb_ind);
+            if (t >= 0 && this->machine_symbol[symb_ind]) pred_start[t + 1]++;
+        }
+    }
+    for (int s = 0; s < num_states; s++) pred_start[s + 1] += pred_start[s];
+    preds.resize(pred_start[num_states]);
+    auto fill = std::vector<int>(pred_start.begin(), pred_start.end() - 1);
+    for (int s = 0; s < num_states; s++) {
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            int t = product.apply(s, symb_ind);
+            if (t >= 0 && this->machine_symbol[symb_ind]) preds[fill[t]++] = s;
+        }
+    }
+
+    std::vector<int> distances(num_states, -1);
+    std::vector<int> queue;
+    for (int s = 0; s < num_states; s++) {
+        if (!this->error[s]) continue;
+        distances[s] = 0;
+        queue.push_back(s);
+    }
+    for (int i = 0; i < queue.size(); i++) {
+        int t = queue[i];
+        for (int k = pred_start[t]; k < pred_start[t + 1]; k++) {
+            int s = preds[k];
+            if (distances[s] < 0) {
+                distances[s] = distances[t] + 1;
+                queue.push_back(s);
+            }
+        }
+    }
+    return distances;
+}
+
+std::shared_ptr<const monitor_alignment_t> monitored_machine::cached_align(const dfa& human) const {
+    std::lock_guard<std::mutex> guard(this->alignment_lock);
+    if (this->aligned_alphabet != human.alphabet) {
+        this->alignment = std::make_shared<const monitor_alignment_t>(this->align(human));
+        this->aligned_alphabet = human.alphabet;
+    }
+    return this->alignment;
+}
+
+bool monitored_machine::check(dfa& human, check_workspace& workspace, counterexample_t *trace) const {
+    std::shared_ptr<const monitor_alignment_t> alignment = this->cached_align(human);
+    return this->check(human, *alignment, workspace, trace);
+}
+
+bool monitored_machine::check(dfa& human, const monitor_alignment_t& alignment,
+        check_workspace& workspace, counterexample_t *trace) const {
+    if (this->bitset && trace == nullptr) {
+        return this->bitset->check(human, alignment.human_symbols, alignment.monitor_symbols, workspace);
+    }
+    int num_symbols = alignment.human_symbols.size();
+    const dfa& monitor = *this->product;
+
+    /* Pairs are packed into a single key as human_state * |monitor| + monitor_state */
+    uint64_t num_monitor_states = monitor.num_states;
+    workspace.reset((uint64_t) human.num_states * num_monitor_states, trace != nullptr);
+    uint64_t first = human.initial_state * num_monitor_states + monitor.initial_state;
+    workspace.visit(first);
+    workspace.push(first);
+
+    while (!workspace.empty()) {
+        uint64_t current = workspace.pop();
+        int h = current / num_monitor_states;
+        int m = current % num_monitor_states;
+        for (int k = 0; k < num_symbols; k++) {
+            int h_target = alignment.human_symbols[k] < 0 ? h : human.apply(h, alignment.human_symbols[k]);
+            int m_target = alignment.monitor_symbols[k] < 0 ? m : monitor.apply(m, alignment.monitor_symbols[k]);
+            if (h_target == DFA_DUMMY_SYMBOL || m_target == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+            uint64_t next = h_target * num_monitor_states + m_target;
+            if (this->error[m_target]) {
+                if (trace != nullptr) {
+                    counterexample_build(workspace, {(uint64_t) human.num_states, num_monitor_states},
+                            alignment.symbols, k, next, trace);
+                    /* Split every monitored state into its machine and property states */
+                    std::vector<int> monitored = std::move(trace->states[1]);
+                    trace->states.resize(3);
+                    trace->states[1].clear();
+                    trace->states[2].clear();
+                    for (int m_state : monitored) {
+                        trace->states[1].push_back(monitor.component_states[m_state].first);
+                        trace->states[2].push_back(monitor.component_states[m_state].second);
+                    }
+                }
+                return false;
+            }
+            if (workspace.visit(next)) {
+                workspace.push(next, k);
+            }
+        }
+    }
+    return true;
+}
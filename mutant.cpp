@@ -0,0 +1,79 @@
+/** @file mutant.cpp
+ *  @brief Copy-on-write views of modified DFAs
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include "inc/mutant.h"
+
+/* *****     IMPLEMENTATION     ***** */
+
+dfa_mutant::dfa_mutant(const dfa& base) : base(&base) {}
+
+void dfa_mutant::clear() {
+    this->touched.clear();
+    this->rows.clear();
+}
+
+int *dfa_mutant::edit_row(int state) {
+    int alphabet_size = this->base->alphabet_size;
+    for (size_t i = 0; i < this->touched.size(); i++) {
+        if (this->touched[i] == state) return &this->rows[(size_t) i * alphabet_size];
+    }
+    const int *base_row = &this->base->transition_matrix[(size_t) state * alphabet_size];
+    this->touched.push_back(state);
+    this->rows.insert(this->rows.end(), base_row, base_row + alphabet_size);
+    return &this->rows[this->rows.size() - alphabet_size];
+}
+
+void dfa_mutant::set(int state, int symbol_index, int target) {
+    this->edit_row(state)[symbol_index] = target;
+}
+
+int dfa_mutant::modify(dfa& original_pattern, dfa& target_pattern, const pattern_output& pattern) {
+    int original_asize = original_pattern.alphabet_size;
+    int target_asize = target_pattern.alphabet_size;
+    if (original_pattern.num_states != target_pattern.num_states ||
+            original_asize != target_asize) {
+        return DFA_NOT_YET_IMPL;
+    }
+
+    int pattern_states = original_pattern.num_states;
+    for (int state_no = 0; state_no < pattern_states; state_no++) {
+        int *row = this->edit_row(pattern.states[state_no]);
+        for (int symbol_no = 0; symbol_no < original_asize; symbol_no++) {
+            int symbol_ind = this->base->get_symbol_index(pattern.symbols[symbol_no]);
+            if (symbol_ind == DFA_INVALID_SYMBOL) {
+                return DFA_PATTERN_NOT_FOUND;
+            }
+            int target = target_pattern.apply(state_no, symbol_no);
+            row[symbol_ind] = target == DFA_DUMMY_SYMBOL ? DFA_DUMMY_SYMBOL : pattern.states[target];
+        }
+    }
+    return 0;
+}
+
+void dfa_mutant::write(dfa& M) const {
+    int alphabet_size = this->base->alphabet_size;
+    for (size_t i = 0; i < this->touched.size(); i++) {
+        const int *row = &this->rows[(size_t) i * alphabet_size];
+        std::copy(row, row + alphabet_size,
+                &M.transition_matrix[(size_t) this->touched[i] * alphabet_size]);
+    }
+}
+
+void dfa_mutant::revert(dfa& M) const {
+    int alphabet_size = this->base->alphabet_size;
+    for (int state : this->touched) {
+        const int *base_row = &this->base->transition_matrix[(size_t) state * alphabet_size];
+        std::copy(base_row, base_row + alphabet_size, &M.transition_matrix[(size_t) state * alphabet_size]);
+    }
+}
+
+dfa *dfa_mutant::to_dfa() const {
+    dfa *M = new dfa(*this->base);
+    this->write(*M);
+    return M;
+}
@@ -7,6 +7,7 @@
 
 #include "inc/DFA.h"
 #include "inc/modify.h"
+#include "inc/pattern_lib.h"
 
 /** @brief A template for patterns with 3 states in start and end
  *
@@ -14,7 +15,15 @@
  * @param transitions Transition matrix for the corresponding pattern
  * @return zero on success, negative error code on failure
  */
-static dfa *patt_3state_template(int *transitions);
+static dfa *patt_3state_template(const int *transitions);
+
+/** @brief Adds a map to the library, which takes ownership of its patterns
+ *
+ * @param library Library to add to
+ * @param initial Initial pattern of the map
+ * @param target Target pattern of the map
+ */
+static void patternlib_add(pattern_library_t &library, dfa *initial, dfa *target);
 
 /** @brief Initialize a dfa with a pattern with the generic starting configuration
  *
@@ -75,7 +84,7 @@ static dfa *patt_repetition_post();
 
 /* *****     IMPLEMENTATION     ***** */
 
-static dfa *patt_3state_template(int *transitions) {
+static dfa *patt_3state_template(const int *transitions) {
     const int NUM_STATES = 3;
     auto finals = std::vector<bool>(NUM_STATES, false);
 
@@ -86,70 +95,57 @@ static dfa *patt_3state_template(int *transitions) {
 }
 
 static dfa *patt_generic_pre() {
-    int *transitions = new int[6] {1,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {1,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
 static dfa *patt_prematrurestart_post() {
-    int *transitions = new int[6] {1,1,DFA_DUMMY_SYMBOL,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {1,1,DFA_DUMMY_SYMBOL,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
 static dfa *patt_delaystart_post() {
-    int *transitions = new int[6] {1,DFA_DUMMY_SYMBOL,2,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {1,DFA_DUMMY_SYMBOL,2,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
 static dfa *patt_omission_post() {
-    int *transitions = new int[6] {2,2,DFA_DUMMY_SYMBOL,2,DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {2,2,DFA_DUMMY_SYMBOL,2,DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
 static dfa *patt_reversal_post() {
-    int *transitions = new int[6] {1,1,2,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {1,1,2,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
 static dfa *patt_intrusion_pre() {
-    int *transitions = new int[6] {1,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {1,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
 static dfa *patt_intrusion_post() {
-    int *transitions = new int[6] {1,1,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {1,1,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
 static dfa *patt_repetition_post() {
-    int *transitions = new int[6] {0,1,0,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
+    const int transitions[6] = {0,1,0,2,DFA_DUMMY_SYMBOL,DFA_DUMMY_SYMBOL};
     return patt_3state_template(transitions);
 }
 
-void patternlib_init(mapping_list &mappings) {
-
-    auto prematurestart_pre = patt_generic_pre();
-    auto prematurestart_post = patt_prematrurestart_post();
-    modify_add_to_mappings(mappings, *modify_new_pattern_map(*prematurestart_pre, *prematurestart_post));
-
-    auto delaystart_pre = patt_generic_pre();
-    auto delaystart_post = patt_delaystart_post();
-    modify_add_to_mappings(mappings, *modify_new_pattern_map(*delaystart_pre, *delaystart_post));
-
-    auto omission_pre = patt_generic_pre();
-    auto omission_post = patt_omission_post();
-    modify_add_to_mappings(mappings, *modify_new_pattern_map(*omission_pre, *omission_post));
-
-    auto reversal_pre = patt_generic_pre();
-    auto reversal_post = patt_reversal_post();
-    modify_add_to_mappings(mappings, *modify_new_pattern_map(*reversal_pre, *reversal_post));
-
-    auto intrusion_pre = patt_intrusion_pre();
-    auto intrusion_post = patt_intrusion_post();
-    modify_add_to_mappings(mappings, *modify_new_pattern_map(*intrusion_pre, *intrusion_post));
-
-    auto repetition_pre = patt_generic_pre();
-    auto repetition_post = patt_repetition_post();
-    modify_add_to_mappings(mappings, *modify_new_pattern_map(*repetition_pre, *repetition_post));
+static void patternlib_add(pattern_library_t &library, dfa *initial, dfa *target) {
+    library.patterns.emplace_back(initial);
+    library.patterns.emplace_back(target);
+    library.maps.emplace_back(modify_new_pattern_map(*initial, *target));
+    modify_add_to_mappings(library.mappings, *library.maps.back());
 }
 
-
+void patternlib_init(pattern_library_t &library) {
+    patternlib_add(library, patt_generic_pre(), patt_prematrurestart_post());
+    patternlib_add(library, patt_generic_pre(), patt_delaystart_post());
+    patternlib_add(library, patt_generic_pre(), patt_omission_post());
+    patternlib_add(library, patt_generic_pre(), patt_reversal_post());
+    patternlib_add(library, patt_intrusion_pre(), patt_intrusion_post());
+    patternlib_add(library, patt_generic_pre(), patt_repetition_post());
+}
@@ -0,0 +1,307 @@
+/** @file pattern_match.cpp
+ *  @brief Pattern matching engine
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include "inc/pattern_match.h"
+
+/** @brief Finds the first host symbol in a set at or after a position which is not used
+ *
+ * @param set Host symbol set
+ * @param num_words Number of words in the set
+ * @param from First symbol to consider
+ * @param used Whether each host symbol is already used
+ * @return The symbol, or -1 if there is none
+ */
+static int next_free_symbol(const uint64_t *set, int num_words, int from,
+        const std::vector<char>& used);
+
+/* *****     IMPLEMENTATION     ***** */
+
+pattern_matcher::pattern_matcher(const dfa& host, const dfa& pattern)
+        : host(host), pattern(pattern) {
+    int pattern_states = pattern.num_states;
+    int pattern_alphabet_size = pattern.alphabet_size;
+    int host_alphabet_size = host.alphabet_size;
+    this->num_words = (host_alphabet_size + 63) / 64;
+
+    /* Degrees of every state and number of states defining every symbol */
+    this->pattern_degree.assign(pattern_states, 0);
+    this->host_degree.assign(host.num_states, 0);
+    auto pattern_symbol_count = std::vector<int>(pattern_alphabet_size, 0);
+    auto host_symbol_count = std::vector<int>(host_alphabet_size, 0);
+    for (int q = 0; q < pattern_states; q++) {
+        for (int i = 0; i < pattern_alphabet_size; i++) {
+            if (pattern.apply(q, i) == DFA_DUMMY_SYMBOL) continue;
+            this->pattern_degree[q]++;
+            pattern_symbol_count[i]++;
+        }
+    }
+    for (int s = 0; s < host.num_states; s++) {
+        for (int sigma = 0; sigma < host_alphabet_size; sigma++) {
+            if (host.apply(s, sigma) == DFA_DUMMY_SYMBOL) continue;
+            this->host_degree[s]++;
+            host_symbol_count[sigma]++;
+        }
+    }
+
+    /* Sort the pattern transitions by the point in the search at which they can be
+     * checked */
+    this->closing_edges.resize(pattern_states);
+    this->opening_edges.resize(pattern_states);
+    this->entry_edge.assign(pattern_states, -1);
+    for (int q = 0; q < pattern_states; q++) {
+        for (int i = 0; i < pattern_alphabet_size; i++) {
+            int d = pattern.apply(q, i);
+            if (d == DFA_DUMMY_SYMBOL) continue;
+            int edge = q * pattern_alphabet_size + i;
+            this->closing_edges[std::max(q, d)].push_back(edge);
+            if (d > q) {
+                this->opening_edges[q].push_back(edge);
+                if (this->entry_edge[d] < 0) this->entry_edge[d] = edge;
+            }
+        }
+    }
+
+    /* A pattern symbol can only map to host symbols defined in at least as many states */
+    this->candidates.assign((size_t) (pattern_states + 1) * pattern_alphabet_size * this->num_words, 0);
+    for (int i = 0; i < pattern_alphabet_size; i++) {
+        uint64_t *set = this->symbol_set(0, i);
+        for (int sigma = 0; sigma < host_alphabet_size; sigma++) {
+            if (host_symbol_count[sigma] >= pattern_symbol_count[i]) {
+                set[sigma / 64] |= 1ULL << (sigma % 64);
+            }
+        }
+    }
+
+    this->state_candidates.resize(pattern_states);
+    this->state_cursor.assign(pattern_states, 0);
+    this->states.assign(pattern_states, -1);
+    this->state_used.assign(host.num_states, 0);
+    this->symbols.assign(pattern_alphabet_size, -1);
+    this->symbol_used.assign(host_alphabet_size, 0);
+    this->level = 0;
+    this->symbol_level = 0;
+    this->started = false;
+    this->finished = false;
+}
+
+void pattern_matcher::collect_state_candidates() {
+    int q = this->level;
+    std::vector<int>& out = this->state_candidates[q];
+    out.clear();
+    this->state_cursor[q] = 0;
+
+    if (this->entry_edge[q] >= 0) {
+        /* q is entered from an assigned state, so it can only be one of that state's
+         * successors on a symbol still possible for the entering transition */
+        int j = this->entry_edge[q] / this->pattern.alphabet_size;
+        int i = this->entry_edge[q] % this->pattern.alphabet_size;
+        const uint64_t *set = this->symbol_set(q, i);
+        for (int sigma = next_free_symbol(set, this->num_words, 0, this->symbol_used);
+                sigma >= 0; sigma = next_free_symbol(set, this->num_words, sigma + 1, this->symbol_used)) {
+            int target = this->host.apply(this->states[j], sigma);
+            if (target != DFA_DUMMY_SYMBOL && this->host_degree[target] >= this->pattern_degree[q]) {
+                out.push_back(target);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    } else {
+        for (int s = 0; s < this->host.num_states; s++) {
+            if (this->host_degree[s] >= this->pattern_degree[q]) out.push_back(s);
+        }
+    }
+}
+
+bool pattern_matcher::assign_state(int host_state) {
+    int q = this->level;
+    int pattern_alphabet_size = this->pattern.alphabet_size;
+    if (this->state_used[host_state]) return false;
+    this->states[q] = host_state;
+
+    std::copy(this->symbol_set(q, 0), this->symbol_set(q + 1, 0), this->symbol_set(q + 1, 0));
+
+    /* Transitions with both endpoints assigned pin down their symbol exactly */
+    for (int edge : this->closing_edges[q]) {
+        int j = edge / pattern_alphabet_size;
+        int i = edge % pattern_alphabet_size;
+        int source = this->states[j];
+        int target = this->states[this->pattern.apply(j, i)];
+        uint64_t *set = this->symbol_set(q + 1, i);
+        uint64_t any = 0;
+        for (int w = 0; w < this->num_words; w++) {
+            for (uint64_t bits = set[w]; bits; bits &= bits - 1) {
+                int sigma = w * 64 + __builtin_ctzll(bits);
+                if (this->host.apply(source, sigma) != target) set[w] &= ~(1ULL << (sigma % 64));
+            }
+            any |= set[w];
+        }
+        if (!any) return false;
+    }
+
+    /* Transitions out of q to unassigned states at least need to be defined */
+    for (int edge : this->opening_edges[q]) {
+        uint64_t *set = this->symbol_set(q + 1, edge % pattern_alphabet_size);
+        uint64_t any = 0;
+        for (int w = 0; w < this->num_words; w++) {
+            for (uint64_t bits = set[w]; bits; bits &= bits - 1) {
+                int sigma = w * 64 + __builtin_ctzll(bits);
+                if (this->host.apply(host_state, sigma) == DFA_DUMMY_SYMBOL) {
+                    set[w] &= ~(1ULL << (sigma % 64));
+                }
+            }
+            any |= set[w];
+        }
+        if (!any) return false;
+    }
+    return true;
+}
+
+bool pattern_matcher::next_state_assignment() {
+    int pattern_states = this->pattern.num_states;
+    while (true) {
+        int q = this->level;
+        if (this->state_cursor[q] < this->state_candidates[q].size()) {
+            int s = this->state_candidates[q][this->state_cursor[q]++];
+            if (!this->assign_state(s)) continue;
+            this->state_used[s] = 1;
+            this->level++;
+            if (this->level == pattern_states) return true;
+            this->collect_state_candidates();
+        } else {
+            if (q == 0) return false;
+            this->level--;
+            this->state_used[this->states[this->level]] = 0;
+        }
+    }
+}
+
+bool pattern_matcher::next_symbol_assignment() {
+    int pattern_alphabet_size = this->pattern.alphabet_size;
+    int pattern_states = this->pattern.num_states;
+    while (this->symbol_level < pattern_alphabet_size) {
+        int i = this->symbol_level;
+        int sigma = next_free_symbol(this->symbol_set(pattern_states, i), this->num_words,
+                this->symbols[i] + 1, this->symbol_used);
+        if (sigma >= 0) {
+            this->symbols[i] = sigma;
+            this->symbol_used[sigma] = 1;
+            this->symbol_level++;
+            if (this->symbol_level < pattern_alphabet_size) {
+                this->symbols[this->symbol_level] = -1;
+            }
+        } else {
+            this->symbols[i] = -1;
+            if (i == 0) return false;
+            this->symbol_level--;
+            this->symbol_used[this->symbols[this->symbol_level]] = 0;
+        }
+    }
+    return true;
+}
+
+bool pattern_matcher::next(pattern_output& output) {
+    int pattern_states = this->pattern.num_states;
+    int pattern_alphabet_size = this->pattern.alphabet_size;
+    if (this->finished) return false;
+
+    bool found = false;
+    if (!this->started) {
+        this->started = true;
+        if (pattern_states > 0 && pattern_states <= this->host.num_states) {
+            this->collect_state_candidates();
+        } else {
+            this->finished = true;
+            return false;
+        }
+    } else if (pattern_alphabet_size > 0) {
+        /* Resume the symbol search after the last instance */
+        this->symbol_level--;
+        this->symbol_used[this->symbols[this->symbol_level]] = 0;
+        found = this->next_symbol_assignment();
+    }
+
+    while (!found) {
+        if (this->level == pattern_states) {
+            this->level--;
+            this->state_used[this->states[this->level]] = 0;
+        }
+        if (!this->next_state_assignment()) {
+            this->finished = true;
+            return false;
+        }
+        this->symbol_level = 0;
+        if (pattern_alphabet_size > 0) this->symbols[0] = -1;
+        found = this->next_symbol_assignment();
+    }
+
+    output.states = this->states;
+    output.symbols.resize(pattern_alphabet_size);
+    for (int i = 0; i < pattern_alphabet_size; i++) {
+        output.symbols[i] = this->host.alphabet->symbols[this->symbols[i]];
+    }
+    return true;
+}
+
+match_cache::match_cache() {
+    this->hashed_host = nullptr;
+    this->host_hash = 0;
+}
+
+int match_cache::lookup(const dfa& host, const dfa& pattern) {
+    if (this->hashed_host != &host) {
+        this->hashed_host = &host;
+        this->host_hash = host.DFA_hash();
+    }
+    uint64_t key = this->host_hash * 31 + pattern.DFA_hash();
+    auto range = this->index.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        entry_t *e = this->entries[it->second].get();
+        if ((e->host == &host || e->host->DFA_equal(host)) &&
+                (e->pattern == &pattern || e->pattern->DFA_equal(pattern))) {
+            return it->second;
+        }
+    }
+
+    std::unique_ptr<entry_t> e(new entry_t);
+    e->host = &host;
+    e->pattern = &pattern;
+    e->matcher.reset(new pattern_matcher(host, pattern));
+    int entry_id = this->entries.size();
+    this->entries.push_back(std::move(e));
+    this->index.insert({key, entry_id});
+    return entry_id;
+}
+
+bool match_cache::instance(int entry_id, int instance_no, pattern_output& output) {
+    entry_t *e = this->entries[entry_id].get();
+    std::lock_guard<std::mutex> guard(e->lock);
+    while (e->instances.size() <= instance_no && e->matcher) {
+        pattern_output found;
+        if (e->matcher->next(found)) {
+            e->instances.push_back(std::move(found));
+        } else {
+            e->matcher.reset();
+        }
+    }
+    if (instance_no >= e->instances.size()) return false;
+    output = e->instances[instance_no];
+    return true;
+}
+
+static int next_free_symbol(const uint64_t *set, int num_words, int from,
+        const std::vector<char>& used) {
+    for (int w = from / 64; w < num_words; w++) {
+        uint64_t bits = set[w];
+        if (w == from / 64) bits &= ~0ULL << (from % 64);
+        for (; bits; bits &= bits - 1) {
+            int sigma = w * 64 + __builtin_ctzll(bits);
+            if (!used[sigma]) return sigma;
+        }
+    }
+    return -1;
+}
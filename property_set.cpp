@@ -0,0 +1,206 @@
+/** @file property_set.cpp
+ *  @brief Sets of properties checked together
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <unordered_map>
+#include "inc/property_set.h"
+
+/* Reachable part of a composition, as an explicit graph */
+typedef struct property_set_graph {
+    int num_components;         /* Number of composed DFAs */
+    int alphabet_size;          /* Number of symbols of the composition */
+    std::vector<int> tuples;    /* Component states of each graph state */
+    std::vector<int> successors;    /* Successor of each graph state on each symbol,
+                                 * or DFA_DUMMY_SYMBOL if blocked */
+} property_set_graph_t;
+
+/** @brief Explores the reachable part of a composition into a graph
+ *
+ * @param components DFAs composed together
+ * @param alphabet Alphabet of the composition
+ * @param graph Where to store the graph; state 0 is the initial state
+ */
+static void graph_build(const std::vector<const dfa*> &components, const dfa_alphabet &alphabet,
+        property_set_graph_t &graph);
+
+/** @brief Checks one property against a composition graph
+ *
+ * Graph and property states are packed into a single key as graph_state * |P| +
+ * prop_state.  If a trace is requested, trace->states holds graph states, then
+ * property states.
+ *
+ * @param graph Composition graph
+ * @param p Property to check
+ * @param steps Property state after each symbol from each property state
+ * @param symbol_ids Interned ID of each symbol of the composition
+ * @param workspace Storage for the visited set and frontier
+ * @param trace Where to store a counterexample on a violation, or nullptr
+ * @return True if the property is satisfied, false if not
+ */
+static bool graph_check(const property_set_graph_t &graph, const Property &p,
+        const std::vector<int> &steps, const std::vector<int> &symbol_ids,
+        check_workspace &workspace, counterexample_t *trace);
+
+/* *****     IMPLEMENTATION     ***** */
+
+void PropertySet::add(Property &p) {
+    this->properties.push_back(&p);
+}
+
+property_set_result_t PropertySet::check(dfa &M) const {
+    property_set_result_t result;
+    this->check_components({&M}, result);
+    return result;
+}
+
+property_set_result_t PropertySet::check(dfa &M1, dfa &M2) const {
+    property_set_result_t result;
+    this->check_components({&M1, &M2}, result);
+    return result;
+}
+
+void PropertySet::check_components(const std::vector<const dfa*> &components,
+        property_set_result_t &result) const {
+    int num_properties = this->properties.size();
+    result.satisfied.assign(num_properties, true);
+    result.witnesses.assign(num_properties, counterexample_t());
+    bool any_violable = false;
+    for (Property *p : this->properties) any_violable = any_violable || p->can_be_violated();
+    if (!any_violable) {
+        return;
+    }
+
+    std::shared_ptr<const dfa_alphabet> alphabet = components.size() == 1 ? components[0]->alphabet :
+            DFA_union_alphabet(*components[0], *components[1]);
+    property_set_graph_t graph;
+    graph_build(components, *alphabet, graph);
+
+    check_workspace workspace;
+    for (int i = 0; i < num_properties; i++) {
+        const Property &p = *this->properties[i];
+        if (!p.can_be_violated()) {
+            continue;
+        }
+        const dfa &prop_dfa = p.get_dfa();
+        int num_prop_states = prop_dfa.num_states;
+
+        /* Transitions of the property over the composition's symbols, with NOP semantics */
+        std::vector<int> steps((size_t) graph.alphabet_size * num_prop_states);
+        for (int symb_ind = 0; symb_ind < graph.alphabet_size; symb_ind++) {
+            int prop_symbol = prop_dfa.get_symbol_index(alphabet->symbols[symb_ind]);
+            for (int q = 0; q < num_prop_states; q++) {
+                int tq = prop_symbol < 0 ? DFA_INVALID_SYMBOL : prop_dfa.apply(q, prop_symbol);
+                steps[(size_t) symb_ind * num_prop_states + q] = tq < 0 ? q : tq;
+            }
+        }
+        if (graph_check(graph, p, steps, alphabet->symbols, workspace, nullptr)) {
+            continue;
+        }
+
+        /* Only violated properties are traced, stopping again at the first error */
+        result.satisfied[i] = false;
+        counterexample_t &witness = result.witnesses[i];
+        graph_check(graph, p, steps, alphabet->symbols, workspace, &witness);
+        std::vector<int> graph_states = std::move(witness.states[0]);
+        std::vector<int> prop_states = std::move(witness.states[1]);
+        witness.states.assign(graph.num_components + 1, std::vector<int>());
+        for (int g : graph_states) {
+            for (int c = 0; c < graph.num_components; c++) {
+                witness.states[c].push_back(graph.tuples[(size_t) g * graph.num_components + c]);
+            }
+        }
+        witness.states[graph.num_components] = std::move(prop_states);
+    }
+}
+
+static void graph_build(const std::vector<const dfa*> &components, const dfa_alphabet &alphabet,
+        property_set_graph_t &graph) {
+    int num_components = components.size();
+    int alphabet_size = alphabet.symbols.size();
+    graph.num_components = num_components;
+    graph.alphabet_size = alphabet_size;
+    std::vector<int> symbol_index((size_t) alphabet_size * num_components);
+    for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+        for (int c = 0; c < num_components; c++) {
+            symbol_index[(size_t) symb_ind * num_components + c] =
+                    components[c]->get_symbol_index(alphabet.symbols[symb_ind]);
+        }
+    }
+
+    /* Worklist expansion from the initial tuple; states are numbered in discovery
+     * order, so rows of successors are appended exactly in state order.  Tuples
+     * are packed into a single key in mixed radix, first component most significant */
+    std::unordered_map<uint64_t, int> ids;
+    uint64_t first = 0;
+    for (int c = 0; c < num_components; c++) {
+        graph.tuples.push_back(components[c]->initial_state);
+        first = first * components[c]->num_states + components[c]->initial_state;
+    }
+    ids.insert({first, 0});
+    std::vector<int> target(num_components);
+    for (int current = 0; current < (int) (graph.tuples.size() / num_components); current++) {
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            bool blocked = false;
+            uint64_t key = 0;
+            for (int c = 0; c < num_components && !blocked; c++) {
+                int s = graph.tuples[(size_t) current * num_components + c];
+                int index = symbol_index[(size_t) symb_ind * num_components + c];
+                target[c] = index < 0 ? s : components[c]->apply(s, index);
+                blocked = target[c] == DFA_DUMMY_SYMBOL;
+                key = key * components[c]->num_states + target[c];
+            }
+            if (blocked) {
+                graph.successors.push_back(DFA_DUMMY_SYMBOL);
+                continue;
+            }
+            auto inserted = ids.insert({key, (int) (graph.tuples.size() / num_components)});
+            if (inserted.second) {
+                graph.tuples.insert(graph.tuples.end(), target.begin(), target.end());
+            }
+            graph.successors.push_back(inserted.first->second);
+        }
+    }
+}
+
+static bool graph_check(const property_set_graph_t &graph, const Property &p,
+        const std::vector<int> &steps, const std::vector<int> &symbol_ids,
+        check_workspace &workspace, counterexample_t *trace) {
+    int alphabet_size = graph.alphabet_size;
+    uint64_t num_graph_states = graph.tuples.size() / graph.num_components;
+    uint64_t num_prop_states = p.get_dfa().num_states;
+    workspace.reset(num_graph_states * num_prop_states, trace != nullptr);
+    uint64_t first = p.get_dfa().initial_state;
+    workspace.visit(first);
+    workspace.push(first);
+
+    while (!workspace.empty()) {
+        uint64_t current = workspace.pop();
+        int g = current / num_prop_states;
+        int q = current % num_prop_states;
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            int tg = graph.successors[(size_t) g * alphabet_size + symb_ind];
+            if (tg == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+            int tq = steps[(size_t) symb_ind * num_prop_states + q];
+            uint64_t next = tg * num_prop_states + tq;
+            if (p.is_error_state(tq)) {
+                if (trace != nullptr) {
+                    counterexample_build(workspace, {num_graph_states, num_prop_states},
+                            symbol_ids, symb_ind, next, trace);
+                }
+                return false;
+            }
+            if (!p.can_reach_error(tq)) {
+                continue;
+            }
+            if (workspace.visit(next)) {
+                workspace.push(next, symb_ind);
+            }
+        }
+    }
+    return true;
+}
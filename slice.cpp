@@ -0,0 +1,204 @@
+/** @file slice.cpp
+ *  @brief Alphabet slicing of compositions
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <algorithm>
+#include <map>
+#include "inc/check_workspace.h"
+#include "inc/slice.h"
+
+/** @brief Closes a set of states under the hidden symbols of a DFA
+ *
+ * @param M DFA the states belong to
+ * @param hidden Indices of the hidden symbols of M
+ * @param states Set to close, updated in place and sorted
+ * @param seen Scratch flags of every state of M, all false on entry and on return
+ */
+static void slice_close(const dfa &M, const std::vector<int> &hidden, std::vector<int> &states,
+        std::vector<bool> &seen);
+
+/* *****     IMPLEMENTATION     ***** */
+
+std::vector<int> slice_relevant(const dfa &M1, const dfa &M2, const Property &p) {
+    std::vector<int> relevant = p.get_dfa().alphabet->symbols;
+    for (int symbol_id : M1.alphabet->symbols) {
+        if (M2.get_symbol_index(symbol_id) >= 0) {
+            relevant.push_back(symbol_id);
+        }
+    }
+    std::sort(relevant.begin(), relevant.end());
+    relevant.erase(std::unique(relevant.begin(), relevant.end()), relevant.end());
+    return relevant;
+}
+
+static void slice_close(const dfa &M, const std::vector<int> &hidden, std::vector<int> &states,
+        std::vector<bool> &seen) {
+    for (int s : states) seen[s] = true;
+    for (int i = 0; i < states.size(); i++) {
+        for (int symb_ind : hidden) {
+            int target = M.apply(states[i], symb_ind);
+            if (target != DFA_DUMMY_SYMBOL && !seen[target]) {
+                seen[target] = true;
+                states.push_back(target);
+            }
+        }
+    }
+    for (int s : states) seen[s] = false;
+    std::sort(states.begin(), states.end());
+}
+
+dfa *slice_hide(const dfa &M, const std::vector<int> &relevant,
+        std::vector<std::vector<int>> *mapping) {
+    std::vector<int> visible, hidden, visible_ids;
+    for (int symb_ind = 0; symb_ind < M.alphabet_size; symb_ind++) {
+        int symbol_id = M.alphabet->symbols[symb_ind];
+        if (std::binary_search(relevant.begin(), relevant.end(), symbol_id)) {
+            visible.push_back(symb_ind);
+            visible_ids.push_back(symbol_id);
+        } else {
+            hidden.push_back(symb_ind);
+        }
+    }
+    auto alphabet = std::make_shared<const dfa_alphabet>(visible_ids);
+
+    /* Subsets are numbered in discovery order, so rows are appended in state order */
+    std::vector<bool> seen(M.num_states);
+    std::map<std::vector<int>, int> ids;
+    std::vector<std::vector<int>> subsets;
+    std::vector<int> transitions;
+    std::vector<bool> finals;
+
+    subsets.push_back({M.initial_state});
+    slice_close(M, hidden, subsets[0], seen);
+    ids.insert({subsets[0], 0});
+    for (int current = 0; current < subsets.size(); current++) {
+        for (int symb_ind : visible) {
+            std::vector<int> targets;
+            for (int s : subsets[current]) {
+                int target = M.apply(s, symb_ind);
+                if (target != DFA_DUMMY_SYMBOL && !seen[target]) {
+                    seen[target] = true;
+                    targets.push_back(target);
+                }
+            }
+            for (int s : targets) seen[s] = false;
+            if (targets.empty()) {
+                transitions.push_back(DFA_DUMMY_SYMBOL);
+                continue;
+            }
+            slice_close(M, hidden, targets, seen);
+            auto inserted = ids.insert({targets, (int) subsets.size()});
+            if (inserted.second) {
+                subsets.push_back(std::move(targets));
+            }
+            transitions.push_back(inserted.first->second);
+        }
+        bool final = false;
+        for (int s : subsets[current]) final = final || M.final_states.count(s) > 0;
+        finals.push_back(final);
+    }
+
+    if (mapping != nullptr) {
+        *mapping = subsets;
+    }
+    return new dfa(subsets.size(), 0, finals, alphabet, transitions.data());
+}
+
+bool slice_expand(counterexample_t *trace, const dfa &M1, const dfa &M2, const Property &p,
+        const std::vector<int> &relevant) {
+    auto alphabet = DFA_union_alphabet(M1, M2);
+    int alphabet_size = alphabet->symbols.size();
+    std::vector<int> symbols_1(alphabet_size), symbols_2(alphabet_size);
+    std::vector<bool> visible(alphabet_size);
+    for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+        int symbol_id = alphabet->symbols[symb_ind];
+        symbols_1[symb_ind] = M1.get_symbol_index(symbol_id);
+        symbols_2[symb_ind] = M2.get_symbol_index(symbol_id);
+        visible[symb_ind] = std::binary_search(relevant.begin(), relevant.end(), symbol_id);
+    }
+    std::vector<int> steps;
+    for (int symbol_id : trace->symbols) {
+        steps.push_back(alphabet->index_of(symbol_id));
+        if (steps.back() == DFA_INVALID_SYMBOL) {
+            return false;
+        }
+    }
+
+    /* Keys are packed as (s1 * |M2| + s2) * (steps + 1) + i, where i counts the
+     * symbols of the trace taken so far */
+    uint64_t num_states_2 = M2.num_states;
+    uint64_t num_steps = steps.size() + 1;
+    check_workspace workspace;
+    workspace.reset((uint64_t) M1.num_states * num_states_2 * num_steps, true);
+    uint64_t first = (M1.initial_state * num_states_2 + M2.initial_state) * num_steps;
+    workspace.visit(first);
+    workspace.push(first);
+
+    bool found = false;
+    while (!workspace.empty()) {
+        uint64_t current = workspace.pop();
+        int i = current % num_steps;
+        if (i == steps.size()) {
+            found = true;
+            break;
+        }
+        int s2 = (current / num_steps) % num_states_2;
+        int s1 = (current / num_steps) / num_states_2;
+        for (int symb_ind = 0; symb_ind < alphabet_size; symb_ind++) {
+            /* The next symbol of the trace is taken in order, hidden ones anywhere */
+            bool taken = symb_ind == steps[i];
+            if (!taken && visible[symb_ind]) {
+                continue;
+            }
+            int t1 = symbols_1[symb_ind] < 0 ? s1 : M1.apply(s1, symbols_1[symb_ind]);
+            int t2 = symbols_2[symb_ind] < 0 ? s2 : M2.apply(s2, symbols_2[symb_ind]);
+            if (t1 == DFA_DUMMY_SYMBOL || t2 == DFA_DUMMY_SYMBOL) {
+                continue;
+            }
+            uint64_t next = (t1 * num_states_2 + t2) * num_steps + i + taken;
+            if (workspace.visit(next)) {
+                workspace.push(next, symb_ind);
+            }
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    std::vector<uint64_t> keys;
+    std::vector<int> path;
+    workspace.trace_back(keys, path);
+    trace->symbols.clear();
+    for (int symb_ind : path) trace->symbols.push_back(alphabet->symbols[symb_ind]);
+    trace->states.assign(3, std::vector<int>(keys.size()));
+    for (int k = 0; k < keys.size(); k++) {
+        trace->states[0][k] = (keys[k] / num_steps) / num_states_2;
+        trace->states[1][k] = (keys[k] / num_steps) % num_states_2;
+    }
+
+    /* The property is composed with NOP semantics, as in Property::property_check */
+    const dfa &prop_dfa = p.get_dfa();
+    std::vector<int> &prop_states = trace->states[2];
+    prop_states[0] = prop_dfa.initial_state;
+    for (int k = 0; k < path.size(); k++) {
+        int symb_ind = prop_dfa.get_symbol_index(trace->symbols[k]);
+        int target = symb_ind < 0 ? DFA_INVALID_SYMBOL : prop_dfa.apply(prop_states[k], symb_ind);
+        prop_states[k + 1] = target < 0 ? prop_states[k] : target;
+    }
+    return true;
+}
+
+bool slice_restore(counterexample_t *trace, dfa &M1, dfa &M2, Property &p,
+        const std::vector<int> &relevant, check_workspace &workspace) {
+    if (slice_expand(trace, M1, M2, p, relevant)) {
+        return true;
+    }
+    if (p.property_check(M1, M2, workspace, trace)) {
+        *trace = counterexample_t();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+/** @file symbol_table.cpp
+ *  @brief Global symbol table
+ *  @author Brian Wei
+ *
+ *  Detailed documentation in header file
+ */
+
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include "inc/symbol_table.h"
+
+/* Names are kept in a deque so references handed out by symbol_name stay valid
+ * as the table grows; the mutex guards against concurrent interning. */
+static std::mutex table_lock;
+static std::deque<std::string> names;
+static std::unordered_map<std::string, int> ids;
+
+/* *****     IMPLEMENTATION     ***** */
+
+int symbol_intern(const std::string& name) {
+    std::lock_guard<std::mutex> guard(table_lock);
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    int id = names.size();
+    names.push_back(name);
+    ids.insert(std::make_pair(name, id));
+    return id;
+}
+
+int symbol_find(const std::string& name) {
+    std::lock_guard<std::mutex> guard(table_lock);
+    auto it = ids.find(name);
+    return it == ids.end() ? SYMBOL_NOT_FOUND : it->second;
+}
+
+const std::string& symbol_name(int id) {
+    std::lock_guard<std::mutex> guard(table_lock);
+    assert(id >= 0 && id < names.size());
+    return names[id];
+}
+
+int symbol_count() {
+    std::lock_guard<std::mutex> guard(table_lock);
+    return names.size();
+}
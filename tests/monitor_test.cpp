@@ -0,0 +1,71 @@
+/** @file monitor_test.cpp
+ *  @brief Tests of saving and loading monitored machines
+ *  @author Brian Wei
+ *
+ *  A monitored machine loaded from a file must be the one that was saved, and
+ *  must only load against the machine and property it was composed from.
+ */
+
+#include <cstdio>
+#include <memory>
+#include "../inc/examples.h"
+#include "../inc/monitor.h"
+
+/** @brief Reports a failed expectation
+ *
+ * @param ok Whether the expectation holds
+ * @param what Description of the expectation
+ * @return 0 if it holds, 1 if not
+ */
+static int test_expect(bool ok, const char *what);
+
+/* *****     IMPLEMENTATION     ***** */
+
+static int test_expect(bool ok, const char *what) {
+    if (!ok) fprintf(stderr, "FAILED: %s\n", what);
+    return ok ? 0 : 1;
+}
+
+int main() {
+    /* Property: three S0 steps lead to the error state 3 */
+    std::vector<bool> finals_4(4, false);
+    const int prop_rows[4] = {1, 2, 3, DFA_DUMMY_SYMBOL};
+    dfa prop_dfa(4, 1, 0, finals_4, {"S0"}, prop_rows);
+    int errors[1] = {3};
+    Property p(prop_dfa, interps::NOP, errors, 1);
+
+    std::unique_ptr<dfa> machine(ex_random(50, 4, 0.8, 3));
+    std::unique_ptr<dfa> other(ex_random(50, 4, 0.8, 4));
+    std::unique_ptr<dfa> human(ex_random(200, 4, 0.9, 5));
+    const char *path = "monitor_test.dfa";
+
+    int failures = 0;
+    monitored_machine built(p, *machine);
+    failures += test_expect(built.save(path) == DFAFILE_NO_ERROR, "the monitored machine is saved");
+
+    std::unique_ptr<monitored_machine> loaded(monitor_load(path, p, *machine));
+    failures += test_expect(loaded != nullptr, "the monitored machine is loaded");
+    if (loaded) {
+        failures += test_expect(loaded->product->DFA_equal(*built.product),
+                "the loaded composition is the saved one");
+        failures += test_expect(loaded->product->component_states == built.product->component_states,
+                "the states of the machine and property are recovered");
+        failures += test_expect(loaded->error == built.error, "the error states are kept");
+
+        check_workspace workspace;
+        counterexample_t built_trace, loaded_trace;
+        bool built_ok = built.check(*human, workspace, &built_trace);
+        bool loaded_ok = loaded->check(*human, workspace, &loaded_trace);
+        failures += test_expect(built_ok == loaded_ok && built_trace.symbols == loaded_trace.symbols &&
+                built_trace.states == loaded_trace.states, "checks against both give the same result");
+    }
+
+    std::unique_ptr<monitored_machine> mismatched(monitor_load(path, p, *other));
+    failures += test_expect(mismatched == nullptr, "a composition of another machine is rejected");
+    std::unique_ptr<monitored_machine> missing(monitor_load("monitor_test_missing.dfa", p, *machine));
+    failures += test_expect(missing == nullptr, "a missing file is rejected");
+    remove(path);
+
+    if (failures == 0) printf("monitor_test: all passed\n");
+    return failures == 0 ? 0 : 1;
+}
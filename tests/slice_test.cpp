@@ -0,0 +1,175 @@
+/** @file slice_test.cpp
+ *  @brief Tests of mapping counterexamples of sliced DFAs back to the original DFAs
+ *  @author Brian Wei
+ *
+ *  Checks slice_restore() both when slice_expand() can map a counterexample back
+ *  and when it cannot.  The latter is forced with a counterexample whose symbols
+ *  the original DFAs cannot perform; the result must then come from a search of
+ *  the original composition, with every state a state of the original DFAs.
+ *  Both are also checked on a composition large enough that the searches queue
+ *  more keys than a workspace's frontier starts with.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include "../inc/examples.h"
+#include "../inc/slice.h"
+#include "../inc/symbol_table.h"
+
+/** @brief Checks that a counterexample is a run of the original composition into an
+ *      error state of the property
+ *
+ * @param trace Counterexample to check
+ * @param M1 First DFA of the composition
+ * @param M2 Second DFA of the composition
+ * @param p Property the counterexample violates
+ * @return True if every step follows the DFAs and the last property state is an error
+ */
+static bool test_valid(const counterexample_t &trace, const dfa &M1, const dfa &M2,
+        const Property &p);
+
+/** @brief Reports a failed expectation
+ *
+ * @param ok Whether the expectation holds
+ * @param what Description of the expectation
+ * @return 0 if it holds, 1 if not
+ */
+static int test_expect(bool ok, const char *what);
+
+/* *****     IMPLEMENTATION     ***** */
+
+static bool test_valid(const counterexample_t &trace, const dfa &M1, const dfa &M2,
+        const Property &p) {
+    const dfa &prop_dfa = p.get_dfa();
+    int length = trace.symbols.size();
+    if (trace.states.size() != 3) return false;
+    for (auto &states : trace.states) {
+        if (states.size() != length + 1) return false;
+    }
+    if (trace.states[0][0] != M1.initial_state || trace.states[1][0] != M2.initial_state ||
+            trace.states[2][0] != prop_dfa.initial_state) {
+        return false;
+    }
+    for (int i = 0; i < length; i++) {
+        int id = trace.symbols[i];
+        int s1 = M1.get_symbol_index(id), s2 = M2.get_symbol_index(id);
+        int sp = prop_dfa.get_symbol_index(id);
+        int t1 = s1 < 0 ? trace.states[0][i] : M1.apply(trace.states[0][i], s1);
+        int t2 = s2 < 0 ? trace.states[1][i] : M2.apply(trace.states[1][i], s2);
+        int tp = sp < 0 ? DFA_INVALID_SYMBOL : prop_dfa.apply(trace.states[2][i], sp);
+        if (tp < 0) tp = trace.states[2][i];
+        if (t1 != trace.states[0][i + 1] || t2 != trace.states[1][i + 1] ||
+                tp != trace.states[2][i + 1]) {
+            return false;
+        }
+    }
+    return p.is_error_state(trace.states[2][length]);
+}
+
+static int test_expect(bool ok, const char *what) {
+    if (!ok) fprintf(stderr, "FAILED: %s\n", what);
+    return ok ? 0 : 1;
+}
+
+int main() {
+    /* Human: 0 -go-> 1.  Machine: 0 -setup-> 1 -go-> 2 -fire-> 3, where setup is a
+     * local action of the machine that the property does not observe.  Property:
+     * 0 -fire-> 1, with 1 the error state. */
+    std::vector<bool> finals_2(2, false), finals_4(4, false);
+    const int human_rows[2] = {1, DFA_DUMMY_SYMBOL};
+    dfa human(2, 1, 0, finals_2, {"go"}, human_rows);
+    const int machine_rows[12] = {
+        DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL, 1,
+        DFA_DUMMY_SYMBOL, 2, DFA_DUMMY_SYMBOL,
+        3, DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL,
+        DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL};
+    dfa machine(4, 3, 0, finals_4, {"fire", "go", "setup"}, machine_rows);
+    const int prop_rows[2] = {1, DFA_DUMMY_SYMBOL};
+    dfa prop_dfa(2, 1, 0, finals_2, {"fire"}, prop_rows);
+    int errors[1] = {1};
+    Property p(prop_dfa, interps::NOP, errors, 1);
+
+    int failures = 0;
+    std::vector<int> relevant = slice_relevant(human, machine, p);
+    failures += test_expect(!std::binary_search(relevant.begin(), relevant.end(),
+            symbol_find("setup")), "setup is not relevant");
+    std::unique_ptr<dfa> sliced(slice_hide(machine, relevant, nullptr));
+    failures += test_expect(sliced->num_states == 3, "setup is hidden in the machine");
+
+    check_workspace workspace;
+    counterexample_t trace;
+    failures += test_expect(!p.property_check(human, *sliced, workspace, &trace),
+            "the sliced composition violates the property");
+
+    /* A counterexample of the sliced machine is mapped back with the hidden step */
+    counterexample_t expanded = trace;
+    failures += test_expect(slice_restore(&expanded, human, machine, p, relevant, workspace),
+            "the counterexample is restored");
+    failures += test_expect(expanded.symbols.size() == 3, "the hidden step is put back");
+    failures += test_expect(test_valid(expanded, human, machine, p),
+            "the restored counterexample is a run of the original DFAs");
+
+    /* A counterexample that cannot be mapped back is searched for again; the human
+     * has no second go, so slice_expand() must fail on it */
+    counterexample_t forged = trace;
+    forged.symbols.insert(forged.symbols.begin(), symbol_find("go"));
+    for (auto &states : forged.states) states.push_back(0);
+    counterexample_t unmapped = forged;
+    failures += test_expect(!slice_expand(&unmapped, human, machine, p, relevant),
+            "slice_expand() fails on symbols the original DFAs cannot perform");
+    failures += test_expect(slice_restore(&forged, human, machine, p, relevant, workspace),
+            "the fallback search finds a counterexample");
+    failures += test_expect(test_valid(forged, human, machine, p),
+            "the fallback counterexample is a run of the original DFAs");
+
+    /* With no counterexample on the original DFAs, the trace is cleared */
+    const int idle_rows[2] = {DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL};
+    dfa idle(2, 1, 0, finals_2, {"go"}, idle_rows);
+    counterexample_t stale = trace;
+    failures += test_expect(!slice_restore(&stale, idle, machine, p, relevant, workspace),
+            "an original composition that satisfies the property is reported");
+    failures += test_expect(stale.symbols.empty() && stale.states.empty(),
+            "the stale counterexample is cleared");
+
+    /* Large human: a random DFA over S0 to S3.  Machine: every step of the human
+     * must be preceded by a local tick.  Property: ten S0 steps lead to the error
+     * state 10.  The frontiers of the searches grow past a few thousand keys before
+     * the error is reached. */
+    std::unique_ptr<dfa> large_human(ex_random(3000, 4, 0.9, 11));
+    std::vector<bool> finals_11(11, false);
+    const int ticker_rows[10] = {
+        DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL, DFA_DUMMY_SYMBOL, 1,
+        0, 0, 0, 0, DFA_DUMMY_SYMBOL};
+    dfa ticker(2, 5, 0, finals_2, {"S0", "S1", "S2", "S3", "tick"}, ticker_rows);
+    const int count_rows[11] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, DFA_DUMMY_SYMBOL};
+    dfa count_dfa(11, 1, 0, finals_11, {"S0"}, count_rows);
+    int count_errors[1] = {10};
+    Property count(count_dfa, interps::NOP, count_errors, 1);
+
+    std::vector<int> large_relevant = slice_relevant(*large_human, ticker, count);
+    std::unique_ptr<dfa> large_sliced(slice_hide(ticker, large_relevant, nullptr));
+    counterexample_t large_trace;
+    failures += test_expect(!count.property_check(*large_human, *large_sliced, workspace, &large_trace),
+            "the large sliced composition violates the property");
+    failures += test_expect(slice_restore(&large_trace, *large_human, ticker, count, large_relevant,
+            workspace), "the large counterexample is restored");
+    int num_ticks = std::count(large_trace.symbols.begin(), large_trace.symbols.end(),
+            symbol_find("tick"));
+    failures += test_expect(num_ticks >= 10 && 2 * num_ticks == large_trace.symbols.size(),
+            "every hidden tick is put back");
+    failures += test_expect(test_valid(large_trace, *large_human, ticker, count),
+            "the restored large counterexample is a run of the original DFAs");
+
+    /* Searched for again on the original composition */
+    counterexample_t large_forged = large_trace;
+    large_forged.symbols.insert(large_forged.symbols.begin(), symbol_find("S1"));
+    for (auto &states : large_forged.states) states.push_back(0);
+    failures += test_expect(slice_restore(&large_forged, *large_human, ticker, count, large_relevant,
+            workspace), "the large fallback search finds a counterexample");
+    failures += test_expect(test_valid(large_forged, *large_human, ticker, count),
+            "the large fallback counterexample is a run of the original DFAs");
+
+    if (failures == 0) printf("slice_test: all passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/** @file workspace_test.cpp
+ *  @brief Tests of counterexamples read back from traced searches
+ *  @author Brian Wei
+ *
+ *  The frontier of a workspace starts with room for 1024 keys and grows when a
+ *  search queues more.  Counterexamples found after the frontier has grown must
+ *  still be runs of the checked DFAs, whichever check recorded them.
+ */
+
+#include <cstdio>
+#include <memory>
+#include "../inc/examples.h"
+#include "../inc/monitor.h"
+
+/** @brief Checks that a counterexample is a run of some DFAs into an error state of
+ *      the property
+ *
+ * @param trace Counterexample to check
+ * @param components DFAs of the composition, in the order of trace->states
+ * @param p Property the counterexample violates
+ * @return True if every step follows the DFAs and the last property state is an error
+ */
+static bool test_valid(const counterexample_t &trace, const std::vector<const dfa*> &components,
+        const Property &p);
+
+/** @brief Reports a failed expectation
+ *
+ * @param ok Whether the expectation holds
+ * @param what Description of the expectation
+ * @return 0 if it holds, 1 if not
+ */
+static int test_expect(bool ok, const char *what);
+
+/* *****     IMPLEMENTATION     ***** */
+
+static bool test_valid(const counterexample_t &trace, const std::vector<const dfa*> &components,
+        const Property &p) {
+    std::vector<const dfa*> all = components;
+    all.push_back(&p.get_dfa());
+    int length = trace.symbols.size();
+    if (trace.states.size() != all.size()) return false;
+    for (int c = 0; c < all.size(); c++) {
+        const std::vector<int> &states = trace.states[c];
+        if (states.size() != length + 1 || states[0] != all[c]->initial_state) return false;
+        for (int i = 0; i < length; i++) {
+            int symb_ind = all[c]->get_symbol_index(trace.symbols[i]);
+            int target = symb_ind < 0 ? states[i] : all[c]->apply(states[i], symb_ind);
+            /* The property stays put on symbols it does not define */
+            if (target < 0 && c == components.size()) target = states[i];
+            if (target != states[i + 1]) return false;
+        }
+    }
+    return p.is_error_state(trace.states.back()[length]);
+}
+
+static int test_expect(bool ok, const char *what) {
+    if (!ok) fprintf(stderr, "FAILED: %s\n", what);
+    return ok ? 0 : 1;
+}
+
+int main() {
+    /* Property: six S0 steps lead to the error state 6 */
+    std::vector<bool> finals_7(7, false);
+    const int prop_rows[7] = {1, 2, 3, 4, 5, 6, DFA_DUMMY_SYMBOL};
+    dfa prop_dfa(7, 1, 0, finals_7, {"S0"}, prop_rows);
+    int errors[1] = {6};
+    Property p(prop_dfa, interps::NOP, errors, 1);
+
+    /* Large enough that the frontier outgrows its initial 1024 keys long before
+     * the error is reached, and small enough to check quickly */
+    std::unique_ptr<dfa> human(ex_random(20000, 8, 0.95, 7));
+    std::unique_ptr<dfa> machine(ex_ring(3, 8));
+
+    int failures = 0;
+    check_workspace workspace;
+    counterexample_t trace;
+    failures += test_expect(!p.property_check(*human, workspace, &trace),
+            "the human violates the property");
+    failures += test_expect(test_valid(trace, {human.get()}, p),
+            "the counterexample of a single DFA is a run");
+
+    failures += test_expect(!p.property_check(*human, *machine, workspace, &trace),
+            "the composition violates the property");
+    failures += test_expect(test_valid(trace, {human.get(), machine.get()}, p),
+            "the counterexample of a composition is a run");
+
+    monitored_machine monitor(p, *machine);
+    failures += test_expect(!monitor.check(*human, workspace, &trace),
+            "the monitored composition violates the property");
+    failures += test_expect(test_valid(trace, {human.get(), machine.get()}, p),
+            "the counterexample of a monitored machine is a run");
+
+    /* A workspace reused after growing gives the same counterexamples */
+    counterexample_t again;
+    p.property_check(*human, workspace, &again);
+    failures += test_expect(test_valid(again, {human.get()}, p),
+            "the counterexample of a reused workspace is a run");
+
+    if (failures == 0) printf("workspace_test: all passed\n");
+    return failures == 0 ? 0 : 1;
+}